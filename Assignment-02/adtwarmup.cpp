@@ -2,16 +2,25 @@
  *  Practice debugging data structures including stacks and queues.
  */
 
+#include "fastcollections.h"
 #include "queue.h"
 #include "stack.h"
+#include "strlib.h"
 #include "SimpleTest.h"
 using namespace std;
 
+/* The functions below are templates over the container types so that
+ * RingQueue and ArrayStack can stand in for Queue and Stack. The timing
+ * test below compares them; see fastcollections.h for when each wins.
+ */
+
 /* This function correctly reverses the elements of a queue.
  */
-void reverse(Queue<int>& q) {
-    Stack<int> s;
+template <typename QueueType, typename StackType>
+void reverse(QueueType& q) {
+    StackType s;
     int num;
+    reserveIfPossible(s, q.size());
 
     while (!q.isEmpty()) {
         num = q.dequeue();
@@ -23,10 +32,15 @@ void reverse(Queue<int>& q) {
     }
 }
 
+void reverse(Queue<int>& q) {
+    reverse<Queue<int>, Stack<int>>(q);
+}
+
 /* This function is intended to modify a queue of characters to duplicate
  * any negative numbers.
  */
-void duplicateNegatives(Queue<int>& q) {
+template <typename QueueType>
+void duplicateNegatives(QueueType& q) {
     int size = q.size();
     for (int i = 0; i < size; i++) {
         int val = q.dequeue();
@@ -37,11 +51,16 @@ void duplicateNegatives(Queue<int>& q) {
     }
 }
 
+void duplicateNegatives(Queue<int>& q) {
+    duplicateNegatives<Queue<int>>(q);
+}
+
 // This function is intended to return the sum of all values in
 // the stack
 // WARNING: the given code is buggy. See exercise writeup for more
 // information on how to test and diagnose.
-int sumStack(Stack<int> s) {
+template <typename StackType>
+int sumStack(StackType s) {
     int total = 0;
     while (!s.isEmpty()) {
         total += s.pop();
@@ -49,9 +68,98 @@ int sumStack(Stack<int> s) {
     return total;
 }
 
+int sumStack(Stack<int> s) {
+    return sumStack<Stack<int>>(s);
+}
+
 
 /* * * * * * Test Cases * * * * * */
 
+/* Test helpers that build containers of 0, -1, 2, -3, ... */
+template <typename QueueType>
+QueueType alternatingQueue(int n) {
+    QueueType q;
+    for (int i = 0; i < n; i++) {
+        q.enqueue(i % 2 ? -i : i);
+    }
+    return q;
+}
+
+template <typename StackType>
+StackType alternatingStack(int n) {
+    StackType s;
+    for (int i = 0; i < n; i++) {
+        s.push(i % 2 ? -i : i);
+    }
+    return s;
+}
+
+STUDENT_TEST("RingQueue and ArrayStack give the same results as Queue and Stack") {
+    Queue<int> q = alternatingQueue<Queue<int>>(100);
+    RingQueue<int> ring = alternatingQueue<RingQueue<int>>(100);
+    reverse<Queue<int>, Stack<int>>(q);
+    reverse<RingQueue<int>, ArrayStack<int>>(ring);
+    duplicateNegatives(q);
+    duplicateNegatives(ring);
+    EXPECT_EQUAL(ring.size(), q.size());
+    EXPECT_EQUAL(ring.toString(), q.toString());
+
+    EXPECT_EQUAL(sumStack(alternatingStack<ArrayStack<int>>(101)), sumStack(alternatingStack<Stack<int>>(101)));
+    ArrayStack<int> s = {1, 8, -5};
+    EXPECT_EQUAL(s.peek(), -5);
+    EXPECT_EQUAL(sumStack(s), 4);
+    EXPECT_EQUAL(s.size(), 3);
+    EXPECT_ERROR(ArrayStack<int>().pop());
+    EXPECT_ERROR(RingQueue<int>().peek());
+
+    ring.clear();
+    EXPECT(ring.isEmpty());
+    ring.enqueue(7);
+    EXPECT_EQUAL(ring.toString(), "{7}");
+}
+
+/* Test helper type with no default constructor. */
+struct Label {
+    explicit Label(string text) : text(text) {
+    }
+    string text;
+};
+
+STUDENT_TEST("RingQueue keeps its elements across wrapping around and growing") {
+    // the front moves around the buffer while the queue grows past it
+    RingQueue<Label> labels;
+    Queue<string> expected;
+    for (int i = 0; i < 100; i++) {
+        labels.enqueue(Label(integerToString(i)));
+        expected.enqueue(integerToString(i));
+        if (i % 3 == 0)
+            EXPECT_EQUAL(labels.dequeue().text, expected.dequeue());
+    }
+    RingQueue<Label> copy = labels;
+    EXPECT_EQUAL(copy.size(), expected.size());
+    while (!expected.isEmpty()) {
+        string text = expected.dequeue();
+        EXPECT_EQUAL(labels.dequeue().text, text);
+        EXPECT_EQUAL(copy.dequeue().text, text);
+    }
+    EXPECT(labels.isEmpty() && copy.isEmpty());
+}
+
+STUDENT_TEST("Time ADT warmup workloads on library and fast containers") {
+    int n = 1000000;
+    Queue<int> q = alternatingQueue<Queue<int>>(n);
+    RingQueue<int> ring = alternatingQueue<RingQueue<int>>(n);
+    TIME_OPERATION(n, (reverse<Queue<int>, Stack<int>>(q)));
+    TIME_OPERATION(n, (reverse<RingQueue<int>, ArrayStack<int>>(ring)));
+    TIME_OPERATION(n, duplicateNegatives(q));
+    TIME_OPERATION(n, duplicateNegatives(ring));
+
+    Stack<int> s = alternatingStack<Stack<int>>(n);
+    ArrayStack<int> array = alternatingStack<ArrayStack<int>>(n);
+    TIME_OPERATION(n, sumStack(s));
+    TIME_OPERATION(n, sumStack(array));
+}
+
 PROVIDED_TEST("reverse queue") {
     Queue<int> q = {1, 2, 3, 4, 5};
     Queue<int> expected = {5, 4, 3, 2, 1};
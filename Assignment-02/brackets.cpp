@@ -0,0 +1,515 @@
+/*
+ * Single-pass bracket checking for inputs too large for the recursive
+ * isBalanced in balanced.cpp.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "brackets.h"
+#include "error.h"
+#include "mappedfile.h"
+#include "random.h"
+#include "recursion.h"
+#include "SimpleTest.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+static const size_t STREAM_BUFFER_SIZE = 1 << 20;
+static const size_t MIN_PARALLEL_SIZE = 4 << 20;
+
+static inline bool isBracket(char ch) {
+    return ch == '(' || ch == ')' || ch == '[' || ch == ']' || ch == '{' || ch == '}';
+}
+
+static inline int lowestBit(uint32_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+BracketChecker::BracketChecker() {
+    reset();
+}
+
+void BracketChecker::reset() {
+    _expected.clear();
+    _failed = false;
+    _offset = 0;
+    _errorOffset = -1;
+    _maxDepth = 0;
+    for (int type = 0; type < 3; type++) {
+        _opened[type] = _closed[type] = 0;
+    }
+}
+
+inline bool BracketChecker::open(int type, char closer) {
+    _opened[type]++;
+    _expected.push_back(closer);
+    _maxDepth = max(_maxDepth, _expected.size());
+    return true;
+}
+
+/*
+ * Handles one bracket. Returns false if it is a closing bracket that does
+ * not match.
+ */
+inline bool BracketChecker::visit(char ch) {
+    switch (ch) {
+        case '(': return open(0, ')');
+        case '[': return open(1, ']');
+        case '{': return open(2, '}');
+        case ')': _closed[0]++; break;
+        case ']': _closed[1]++; break;
+        default:  _closed[2]++; break;
+    }
+    if (_expected.empty() || _expected.back() != ch)
+        return false;
+    _expected.pop_back();
+    return true;
+}
+
+/*
+ * Calls visit(ch) for each bracket ch of data, in order, until visit
+ * returns false. Returns the offset of the bracket for which visit
+ * returned false, or size if there was none. Blocks of 16
+ * characters are matched against all six brackets at once, and only the
+ * positions of the brackets found are visited.
+ */
+template <typename Visit>
+static size_t forEachBracket(const char* data, size_t size, Visit visit) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i open1 = _mm_set1_epi8('('), close1 = _mm_set1_epi8(')');
+    const __m128i open2 = _mm_set1_epi8('['), close2 = _mm_set1_epi8(']');
+    const __m128i open3 = _mm_set1_epi8('{'), close3 = _mm_set1_epi8('}');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i brackets = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, open1), _mm_cmpeq_epi8(chars, close1)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, open2), _mm_cmpeq_epi8(chars, close2)),
+                         _mm_or_si128(_mm_cmpeq_epi8(chars, open3), _mm_cmpeq_epi8(chars, close3))));
+        uint32_t mask = _mm_movemask_epi8(brackets);
+        for (; mask != 0; mask &= mask - 1) {
+            size_t at = i + lowestBit(mask);
+            if (!visit(data[at]))
+                return at;
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (isBracket(data[i]) && !visit(data[i]))
+            return i;
+    }
+    return size;
+}
+
+void BracketChecker::feed(const char* data, size_t size) {
+    if (_failed)
+        return;
+    size_t at = forEachBracket(data, size, [this](char ch) { return visit(ch); });
+    if (at < size) {
+        _failed = true;
+        _errorOffset = _offset + at;
+    }
+    _offset += size;
+}
+
+void BracketChecker::feed(const string& text) {
+    feed(text.data(), text.size());
+}
+
+bool BracketChecker::isBalanced() const {
+    return !_failed && _expected.empty();
+}
+
+bool BracketChecker::hasFailed() const {
+    return _failed;
+}
+
+BracketReport BracketChecker::report() const {
+    BracketReport report;
+    report.balanced = isBalanced();
+    report.errorOffset = _failed ? _errorOffset : _expected.empty() ? -1 : int64_t(_offset);
+    report.maxDepth = _maxDepth;
+    for (int type = 0; type < 3; type++) {
+        report.opened[type] = _opened[type];
+        report.closed[type] = _closed[type];
+    }
+    return report;
+}
+
+bool isBalancedStream(istream& in) {
+    BracketChecker checker;
+    vector<char> buffer(STREAM_BUFFER_SIZE);
+    while (in && !checker.hasFailed()) {
+        in.read(buffer.data(), buffer.size());
+        checker.feed(buffer.data(), size_t(in.gcount()));
+    }
+    return checker.isBalanced();
+}
+
+bool isBalancedFile(string filename) {
+    MappedFile file(filename);
+    BracketChecker checker;
+    checker.feed(file.data(), file.size());
+    return checker.isBalanced();
+}
+
+Vector<BracketReport> lintBracketFiles(const Vector<string>& filenames) {
+    Vector<BracketReport> reports;
+    BracketChecker checker;
+    for (const string& filename : filenames) {
+        MappedFile file(filename);
+        checker.reset();
+        checker.feed(file.data(), file.size());
+        reports.add(checker.report());
+    }
+    return reports;
+}
+
+/*
+ * What a chunk of input leaves for its neighbors to match: closing
+ * brackets with no open bracket before them in the chunk, in order, and
+ * the closing brackets expected by the open ones it leaves, innermost
+ * last. A chunk fails if a closing bracket meets an open one of another
+ * type, which no text outside the chunk can fix.
+ */
+struct BracketSummary {
+    string unmatchedClose;
+    string expected;
+    bool failed;
+};
+
+static BracketSummary summarizeChunk(const char* data, size_t size) {
+    BracketSummary summary;
+    summary.failed = size > forEachBracket(data, size, [&summary](char ch) {
+        switch (ch) {
+            case '(': summary.expected.push_back(')'); return true;
+            case '[': summary.expected.push_back(']'); return true;
+            case '{': summary.expected.push_back('}'); return true;
+            default:
+                if (summary.expected.empty()) {
+                    summary.unmatchedClose.push_back(ch);
+                    return true;
+                }
+                if (summary.expected.back() != ch)
+                    return false;
+                summary.expected.pop_back();
+                return true;
+        }
+    });
+    return summary;
+}
+
+/*
+ * Appends the summary of the chunk after left to it, so left summarizes
+ * both chunks.
+ */
+static void mergeSummaries(BracketSummary& left, const BracketSummary& right) {
+    if (left.failed)
+        return;
+    size_t i = 0;
+    for (; i < right.unmatchedClose.size() && !left.expected.empty(); i++) {
+        if (left.expected.back() != right.unmatchedClose[i]) {
+            left.failed = true;
+            return;
+        }
+        left.expected.pop_back();
+    }
+    // left has no open brackets left if any closes remain
+    left.unmatchedClose.append(right.unmatchedClose, i, string::npos);
+    left.expected += right.expected;
+    left.failed = right.failed;
+}
+
+bool isBalancedParallel(const char* data, size_t size, int numThreads) {
+    if (numThreads <= 0) {
+        if (size < MIN_PARALLEL_SIZE)
+            numThreads = 1;
+        else
+            numThreads = max(1, int(thread::hardware_concurrency()));
+    }
+    vector<BracketSummary> summaries(numThreads);
+    vector<thread> threads;
+    size_t chunkSize = size / numThreads;
+    for (int t = 0; t < numThreads; t++) {
+        size_t begin = t * chunkSize, end = t == numThreads - 1 ? size : begin + chunkSize;
+        if (t == numThreads - 1)
+            summaries[t] = summarizeChunk(data + begin, end - begin);  // the calling thread takes the last one
+        else
+            threads.emplace_back([&summaries, t, data, begin, end] {
+                summaries[t] = summarizeChunk(data + begin, end - begin);
+            });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    for (int t = 1; t < numThreads; t++) {
+        mergeSummaries(summaries[0], summaries[t]);
+    }
+    const BracketSummary& whole = summaries[0];
+    return !whole.failed && whole.unmatchedClose.empty() && whole.expected.empty();
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper that makes text with balanced brackets nested to random
+ * depths, filler characters between them, and the occasional long run of
+ * text with no brackets at all. */
+static string randomBalancedText(size_t length) {
+    static const char openers[] = "([{", closers[] = ")]}";
+    string text, expected;
+    text.reserve(length);
+    while (text.size() < length) {
+        int choice = randomInteger(0, 9);
+        if (choice < 3) {
+            int type = randomInteger(0, 2);
+            text += openers[type];
+            expected += closers[type];
+        } else if (choice < 6 && !expected.empty()) {
+            text += expected.back();
+            expected.pop_back();
+        } else if (choice == 6) {
+            text.append(randomInteger(0, 100), 'x');
+        } else {
+            text += char(randomInteger('a', 'z'));
+        }
+    }
+    text.append(expected.rbegin(), expected.rend());
+    return text;
+}
+
+STUDENT_TEST("BracketChecker agrees with isBalanced") {
+    Vector<string> examples = {"", "x", "()", "(", ")", ")(", "{ ( x } y )", "( ( [ a ] )", "3 ) (",
+                               "int main() { int x = 2 * (vec[2] + 3); x = (1 + random()); }",
+                               "0123456789abcdef(0123456789abcdef)", "0123456789abcdef(0123456789abcde]"};
+    for (const string& example : examples) {
+        BracketChecker checker;
+        checker.feed(example);
+        EXPECT_EQUAL(checker.isBalanced(), isBalanced(example));
+    }
+    setRandomSeed(38);
+    for (int i = 0; i < 200; i++) {
+        string text = randomBalancedText(randomInteger(0, 60));
+        if (randomChance(0.5) && !text.empty())
+            text[randomInteger(0, text.size() - 1)] = "()[]{}x"[randomInteger(0, 6)];
+        BracketChecker checker;
+        checker.feed(text);
+        EXPECT_EQUAL(checker.isBalanced(), isBalanced(text));
+    }
+}
+
+STUDENT_TEST("BracketChecker gives the same answer however input is split") {
+    setRandomSeed(380);
+    string text = randomBalancedText(5000);
+    for (string bad : {string(""), string("]"), string("(")}) {
+        string input = text.substr(0, 2500) + bad + text.substr(2500);
+        for (size_t piece : {1, 7, 16, 100, 5001}) {
+            BracketChecker checker;
+            for (size_t i = 0; i < input.size(); i += piece) {
+                checker.feed(input.data() + i, min(piece, input.size() - i));
+            }
+            EXPECT_EQUAL(checker.isBalanced(), bad.empty());
+        }
+    }
+    BracketChecker checker;
+    checker.feed(")");
+    EXPECT(checker.hasFailed());
+    checker.feed("()");
+    EXPECT(!checker.isBalanced());
+    checker.reset();
+    checker.feed("()");
+    EXPECT(checker.isBalanced());
+}
+
+STUDENT_TEST("isBalancedStream and isBalancedFile check large inputs") {
+    setRandomSeed(3800);
+    string text = randomBalancedText(3 * STREAM_BUFFER_SIZE);
+    {
+        ofstream out("res/brackets.txt", ios::binary);
+        out << text;
+    }
+    ifstream in("res/brackets.txt", ios::binary);
+    EXPECT(isBalancedStream(in));
+    EXPECT(isBalancedFile("res/brackets.txt"));
+    {
+        ofstream out("res/brackets.txt", ios::binary);
+        out << text << "]";
+    }
+    EXPECT(!isBalancedFile("res/brackets.txt"));
+    remove("res/brackets.txt");
+    EXPECT_ERROR(isBalancedFile("res/no-such-file.txt"));
+
+    // deep nesting that would overflow the recursion of isBalanced
+    string deep = string(1000000, '(') + string(1000000, ')');
+    BracketChecker checker;
+    checker.feed(deep);
+    EXPECT(checker.isBalanced());
+}
+
+/* Test helper that finds the report of the original rules: the offset of
+ * the first closing bracket that does not match, and the depth, by
+ * checking ever longer prefixes with isBalanced. */
+static BracketReport referenceReport(const string& text) {
+    BracketReport report = {isBalanced(text), -1, 0, {0, 0, 0}, {0, 0, 0}};
+    size_t depth = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        size_t type = string("([{").find(text[i]);
+        if (type != string::npos) {
+            report.opened[type]++;
+            report.maxDepth = max(report.maxDepth, ++depth);
+        }
+        type = string(")]}").find(text[i]);
+        if (type != string::npos) {
+            report.closed[type]++;
+            // a prefix ending in a matched closing bracket can be completed
+            string prefix = operatorsFrom(text.substr(0, i + 1));
+            string completion;
+            for (char ch : prefix) {
+                if (ch == '(' || ch == '[' || ch == '{')
+                    completion.insert(completion.begin(), ch == '(' ? ')' : ch + 2);
+                else if (!completion.empty())
+                    completion.erase(completion.begin());
+            }
+            if (!operatorsAreMatched(prefix + completion)) {
+                report.errorOffset = i;
+                return report;
+            }
+            depth--;
+        }
+    }
+    if (!report.balanced)
+        report.errorOffset = text.size();
+    return report;
+}
+
+STUDENT_TEST("BracketChecker report finds the first mismatch, depth and counts") {
+    BracketChecker checker;
+    checker.feed("f(a[1], {b}) ]");
+    BracketReport report = checker.report();
+    EXPECT(!report.balanced);
+    EXPECT_EQUAL(report.errorOffset, 13);
+    EXPECT_EQUAL(report.maxDepth, 2);
+    EXPECT_EQUAL(report.opened[0], 1);
+    EXPECT_EQUAL(report.opened[1], 1);
+    EXPECT_EQUAL(report.closed[1], 2);
+    EXPECT_EQUAL(report.opened[2], 1);
+
+    checker.reset();
+    checker.feed("((");
+    checker.feed("x)");
+    EXPECT_EQUAL(checker.report().errorOffset, 4);
+    checker.feed(")");
+    EXPECT_EQUAL(checker.report().errorOffset, -1);
+    EXPECT(checker.report().balanced);
+
+    setRandomSeed(40);
+    for (int i = 0; i < 200; i++) {
+        string text = randomBalancedText(randomInteger(0, 80));
+        if (randomChance(0.7) && !text.empty())
+            text[randomInteger(0, text.size() - 1)] = "()[]{}"[randomInteger(0, 5)];
+        checker.reset();
+        for (size_t j = 0; j < text.size(); j += 10) {
+            checker.feed(text.substr(j, 10));
+        }
+        BracketReport expected = referenceReport(text);
+        report = checker.report();
+        EXPECT_EQUAL(report.balanced, expected.balanced);
+        EXPECT_EQUAL(report.errorOffset, expected.errorOffset);
+        EXPECT_EQUAL(report.maxDepth, expected.maxDepth);
+        for (int type = 0; type < 3; type++) {
+            EXPECT_EQUAL(report.opened[type], expected.opened[type]);
+            EXPECT_EQUAL(report.closed[type], expected.closed[type]);
+        }
+    }
+}
+
+STUDENT_TEST("Time lintBracketFiles on many small files") {
+    setRandomSeed(400);
+    Vector<string> filenames;
+    for (int i = 0; i < 1000; i++) {
+        string filename = "res/lint" + to_string(i) + ".txt";
+        ofstream out(filename, ios::binary);
+        out << randomBalancedText(4096) << (i % 10 == 0 ? "}" : "");
+        filenames.add(filename);
+    }
+    Vector<BracketReport> reports;
+    TIME_OPERATION(filenames.size(), reports = lintBracketFiles(filenames));
+    EXPECT_EQUAL(reports.size(), filenames.size());
+    for (int i = 0; i < reports.size(); i++) {
+        EXPECT_EQUAL(reports[i].balanced, i % 10 != 0);
+        remove(filenames[i].c_str());
+    }
+}
+
+STUDENT_TEST("isBalancedParallel agrees with BracketChecker for any number of chunks") {
+    setRandomSeed(39);
+    for (int i = 0; i < 300; i++) {
+        string text = randomBalancedText(randomInteger(0, 200));
+        for (int k = randomInteger(0, 2); k > 0 && !text.empty(); k--) {
+            text[randomInteger(0, text.size() - 1)] = "()[]{}x"[randomInteger(0, 6)];
+        }
+        BracketChecker checker;
+        checker.feed(text);
+        for (int threads : {1, 2, 3, 8, 64}) {
+            EXPECT_EQUAL(isBalancedParallel(text.data(), text.size(), threads), checker.isBalanced());
+        }
+    }
+    // chunk boundaries inside closes that the chunk before must match
+    string text = string(1000, '[') + "(" + string(1000, ')') + string(1000, ']');
+    EXPECT(!isBalancedParallel(text.data(), text.size(), 4));
+    text = string(1000, '[') + string(1000, '(') + string(1000, ')') + string(1000, ']');
+    EXPECT(isBalancedParallel(text.data(), text.size(), 4));
+    EXPECT(isBalancedParallel("", 0, 4));
+}
+
+/* Test helper that makes size bytes of balanced text by repeating a
+ * random balanced block, which is much faster than generating it all. */
+static string repeatedBalancedText(size_t size) {
+    string block = randomBalancedText(1 << 20);
+    string text;
+    text.reserve(size + block.size());
+    while (text.size() < size) {
+        text += block;
+    }
+    return text;
+}
+
+STUDENT_TEST("Time isBalancedParallel from 1 MB to 1 GB") {
+    setRandomSeed(390);
+    for (size_t size : {size_t(1) << 20, size_t(16) << 20, size_t(128) << 20 /*, size_t(1) << 30 */}) {
+        string text = repeatedBalancedText(size);
+        BracketChecker checker;
+        TIME_OPERATION(text.size(), checker.feed(text));
+        TIME_OPERATION(text.size(), isBalancedParallel(text.data(), text.size()));
+        EXPECT(isBalancedParallel(text.data(), text.size()));
+        EXPECT(checker.isBalanced());
+    }
+}
+
+STUDENT_TEST("Time BracketChecker on large inputs") {
+    setRandomSeed(38000);
+    string code = randomBalancedText(16 << 20);
+    BracketChecker checker;
+    TIME_OPERATION(code.size(), checker.feed(code));
+    EXPECT(checker.isBalanced());
+    string prose(16 << 20, 'x');
+    checker.reset();
+    TIME_OPERATION(prose.size(), checker.feed(prose));
+    EXPECT(checker.isBalanced());
+
+    string small = randomBalancedText(2000);
+    TIME_OPERATION(small.size(), isBalanced(small));
+}
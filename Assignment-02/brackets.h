@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include "vector.h"
+
+/*
+ * What one pass over an input found. Per-type counts are indexed 0 for
+ * ( ), 1 for [ ] and 2 for { }. The pass stops at the first mismatch, so
+ * counts and depth cover the input up to and including that bracket.
+ */
+struct BracketReport {
+    bool balanced;
+    int64_t errorOffset;        // offset of the first closing bracket that does not match,
+                                // the input size if brackets are left open, or -1 if balanced
+    size_t maxDepth;            // most brackets open at once
+    uint64_t opened[3];
+    uint64_t closed[3];
+};
+
+/**
+ * Checks that the bracketing characters ( ) [ ] { } of an input are
+ * balanced, in one left-to-right pass with an explicit stack. Characters
+ * other than brackets are ignored, as in isBalanced from balanced.cpp.
+ *
+ * Input may arrive in pieces of any size through feed, so a file of any
+ * size can be checked with a fixed buffer. Blocks of 16 characters are
+ * tested with SSE2, and only the brackets found in them are visited, so
+ * text with no brackets is skipped at close to memory speed. Memory use is
+ * one byte per bracket that is still open.
+ */
+class BracketChecker {
+public:
+    BracketChecker();
+
+    /**
+     * Forgets all input, to start checking a new one.
+     */
+    void reset();
+
+    /**
+     * Checks the next size characters of the input. Once a mismatch has
+     * been found, further input is ignored.
+     */
+    void feed(const char* data, size_t size);
+    void feed(const std::string& text);
+
+    /**
+     * Returns whether all input fed since the last reset is balanced.
+     * Until the input is complete, brackets still open make this false.
+     */
+    bool isBalanced() const;
+
+    /**
+     * Returns whether a closing bracket has been found that does not match
+     * the innermost open bracket, or has no open bracket to match.
+     */
+    bool hasFailed() const;
+
+    /**
+     * Returns the report on all input fed since the last reset. The
+     * counts it needs are kept as the input is checked.
+     */
+    BracketReport report() const;
+
+private:
+    std::string _expected;      // closing bracket expected for each open one, innermost last
+    bool _failed;
+    uint64_t _offset;           // characters fed so far
+    int64_t _errorOffset;
+    size_t _maxDepth;
+    uint64_t _opened[3], _closed[3];
+
+    bool visit(char ch);
+    bool open(int type, char closer);
+};
+
+/*
+ * Checks all of in, reading it through a fixed-size buffer.
+ */
+bool isBalancedStream(std::istream& in);
+
+/*
+ * Checks the file named filename, which is mapped into memory rather than
+ * read. Raises an error if the file cannot be opened.
+ */
+bool isBalancedFile(std::string filename);
+
+/*
+ * Returns the report on each file, in order. Files are mapped into memory
+ * one at a time and checked by a single checker, whose stack keeps its
+ * capacity from file to file. Raises an error if a file cannot be opened.
+ */
+Vector<BracketReport> lintBracketFiles(const Vector<std::string>& filenames);
+
+/*
+ * Checks data in parallel, with the same result as BracketChecker. The
+ * input is split into one chunk per thread. Each thread reduces its chunk
+ * to a summary: the closing brackets it could not match, and the brackets
+ * it left open. Summaries combine associatively (the opens of the left one
+ * meet the closes of the right one), so the chunks are merged left to
+ * right once all threads finish.
+ *
+ * numThreads of 0 uses one thread per core, and checks inputs below a few
+ * megabytes on the calling thread since starting threads would cost more.
+ */
+bool isBalancedParallel(const char* data, size_t size, int numThreads = 0);
@@ -0,0 +1,331 @@
+#pragma once
+
+/*
+ * Assignment-02/fastcollections.h is the canonical copy of this header;
+ * Assignment-03 has a verbatim copy because each assignment is built as
+ * its own project. Make changes in Assignment-02 and copy them over.
+ */
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "error.h"
+
+/**
+ * A queue with the interface of the Stanford Queue, stored in one ring
+ * buffer whose capacity is a power of two, so that wrapping around is a
+ * mask rather than a branch or a division. Elements sit in one contiguous
+ * block, and the buffer only reallocates when it doubles.
+ *
+ * Each enqueue and dequeue is cheaper than the library Queue's, but a
+ * bigger buffer, whether grown into or reserved, is all new memory, while
+ * the library Queue reuses the blocks it frees as it goes. So RingQueue
+ * wins on queues that are filled and then drained, and can lose on queues
+ * that keep growing while they are drained; time both on the workload.
+ */
+template <typename ValueType>
+class RingQueue {
+public:
+    RingQueue() : _items(nullptr), _capacity(0), _mask(0), _head(0), _count(0) {
+    }
+
+    RingQueue(std::initializer_list<ValueType> list) : RingQueue() {
+        reserve(list.size());
+        for (const ValueType& value : list) {
+            enqueue(value);
+        }
+    }
+
+    RingQueue(const RingQueue& other) : RingQueue() {
+        if (other._count > 0) {
+            allocate(other._count);
+            for (size_t i = 0; i < other._count; i++) {
+                ::new (static_cast<void*>(_items + i)) ValueType(other.at(i));
+            }
+            _count = other._count;
+        }
+    }
+
+    RingQueue(RingQueue&& other) : RingQueue() {
+        swap(other);
+    }
+
+    RingQueue& operator=(RingQueue other) {
+        swap(other);
+        return *this;
+    }
+
+    ~RingQueue() {
+        clear();
+    }
+
+    /*
+     * Makes room for n elements, so that the first n enqueues do not
+     * reallocate.
+     */
+    void reserve(size_t n) {
+        if (n > _capacity)
+            regrow(n);
+    }
+
+    void enqueue(const ValueType& value) {
+        if (_count == _capacity)
+            regrow(_count + 1);
+        ::new (static_cast<void*>(slot(_count))) ValueType(value);
+        _count++;
+    }
+
+    void add(const ValueType& value) {
+        enqueue(value);
+    }
+
+    ValueType dequeue() {
+        if (_count == 0)
+            error("RingQueue::dequeue: Attempting to dequeue an empty queue");
+        ValueType* front = slot(0);
+        ValueType value = std::move(*front);
+        front->~ValueType();
+        _head = (_head + 1) & _mask;
+        _count--;
+        return value;
+    }
+
+    ValueType remove() {
+        return dequeue();
+    }
+
+    const ValueType& peek() const {
+        if (_count == 0)
+            error("RingQueue::peek: Attempting to peek at an empty queue");
+        return at(0);
+    }
+
+    const ValueType& front() const {
+        return peek();
+    }
+
+    const ValueType& back() const {
+        if (_count == 0)
+            error("RingQueue::back: Attempting to read back of an empty queue");
+        return at(_count - 1);
+    }
+
+    int size() const {
+        return int(_count);
+    }
+
+    bool isEmpty() const {
+        return _count == 0;
+    }
+
+    /*
+     * Removes all elements and releases the buffer holding them.
+     */
+    void clear() {
+        for (size_t i = 0; i < _count; i++) {
+            slot(i)->~ValueType();
+        }
+        std::allocator<ValueType>().deallocate(_items, _capacity);
+        _items = nullptr;
+        _capacity = 0;
+        _mask = 0;
+        _head = 0;
+        _count = 0;
+    }
+
+    bool operator==(const RingQueue& other) const {
+        if (_count != other._count)
+            return false;
+        for (size_t i = 0; i < _count; i++) {
+            if (!(at(i) == other.at(i)))
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const RingQueue& other) const {
+        return !(*this == other);
+    }
+
+    std::string toString() const {
+        std::ostringstream out;
+        out << *this;
+        return out.str();
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const RingQueue& queue) {
+        out << "{";
+        for (size_t i = 0; i < queue._count; i++) {
+            out << (i > 0 ? ", " : "") << queue.at(i);
+        }
+        return out << "}";
+    }
+
+private:
+    // only the _count slots from _head on, wrapping around, hold elements;
+    // the others are raw memory, so growing the buffer does not construct
+    // elements that are then overwritten
+    ValueType* _items;
+    size_t _capacity;               // zero or a power of two
+    size_t _mask;                   // _capacity - 1, to wrap an index around
+    size_t _head;                   // index of the front element
+    size_t _count;
+
+    ValueType* slot(size_t i) const {
+        return _items + ((_head + i) & _mask);
+    }
+
+    const ValueType& at(size_t i) const {
+        return *slot(i);
+    }
+
+    void swap(RingQueue& other) {
+        std::swap(_items, other._items);
+        std::swap(_capacity, other._capacity);
+        std::swap(_mask, other._mask);
+        std::swap(_head, other._head);
+        std::swap(_count, other._count);
+    }
+
+    /*
+     * Points _items at a new, empty buffer with the smallest power-of-two
+     * size that holds at least n, without releasing the old one.
+     */
+    void allocate(size_t n) {
+        size_t capacity = 8;
+        while (capacity < n) {
+            capacity *= 2;
+        }
+        _items = std::allocator<ValueType>().allocate(capacity);
+        _capacity = capacity;
+        _mask = capacity - 1;
+        _head = 0;
+    }
+
+    /*
+     * Moves the elements, in order from the front, into a new buffer that
+     * holds at least n.
+     */
+    void regrow(size_t n) {
+        ValueType* old = _items;
+        size_t oldCapacity = _capacity, oldMask = _mask, oldHead = _head;
+        allocate(n);
+        for (size_t i = 0; i < _count; i++) {
+            ValueType* from = old + ((oldHead + i) & oldMask);
+            ::new (static_cast<void*>(_items + i)) ValueType(std::move(*from));
+            from->~ValueType();
+        }
+        std::allocator<ValueType>().deallocate(old, oldCapacity);
+    }
+};
+
+/**
+ * A stack with the interface of the Stanford Stack, stored in one
+ * std::vector whose end is the top of the stack.
+ */
+template <typename ValueType>
+class ArrayStack {
+public:
+    ArrayStack() {
+    }
+
+    ArrayStack(std::initializer_list<ValueType> list) : _items(list) {
+    }
+
+    void reserve(size_t n) {
+        _items.reserve(n);
+    }
+
+    void push(const ValueType& value) {
+        _items.push_back(value);
+    }
+
+    void add(const ValueType& value) {
+        push(value);
+    }
+
+    ValueType pop() {
+        if (_items.empty())
+            error("ArrayStack::pop: Attempting to pop an empty stack");
+        ValueType value = std::move(_items.back());
+        _items.pop_back();
+        return value;
+    }
+
+    ValueType remove() {
+        return pop();
+    }
+
+    const ValueType& peek() const {
+        if (_items.empty())
+            error("ArrayStack::peek: Attempting to peek at an empty stack");
+        return _items.back();
+    }
+
+    const ValueType& top() const {
+        return peek();
+    }
+
+    int size() const {
+        return int(_items.size());
+    }
+
+    bool isEmpty() const {
+        return _items.empty();
+    }
+
+    void clear() {
+        _items.clear();
+    }
+
+    bool operator==(const ArrayStack& other) const {
+        return _items == other._items;
+    }
+
+    bool operator!=(const ArrayStack& other) const {
+        return _items != other._items;
+    }
+
+    std::string toString() const {
+        std::ostringstream out;
+        out << *this;
+        return out.str();
+    }
+
+    // printed from bottom to top, as the Stanford Stack prints
+    friend std::ostream& operator<<(std::ostream& out, const ArrayStack& stack) {
+        out << "{";
+        for (size_t i = 0; i < stack._items.size(); i++) {
+            out << (i > 0 ? ", " : "") << stack._items[i];
+        }
+        return out << "}";
+    }
+
+private:
+    std::vector<ValueType> _items;
+};
+
+/*
+ * Makes room for n elements in containers that can reserve space, and
+ * does nothing for the others, so that code templated over the container
+ * type can preallocate when the size is known.
+ */
+template <typename Container>
+void reserveIfPossible(Container&, size_t) {
+}
+
+template <typename ValueType>
+void reserveIfPossible(RingQueue<ValueType>& queue, size_t n) {
+    queue.reserve(n);
+}
+
+template <typename ValueType>
+void reserveIfPossible(ArrayStack<ValueType>& stack, size_t n) {
+    stack.reserve(n);
+}
@@ -0,0 +1,332 @@
+/*
+ * Bit-packed maze representation and an index-based BFS solver that
+ * scales to mazes with hundreds of millions of cells.
+ */
+
+#include "error.h"
+#include "flatmaze.h"
+#include "maze.h"
+#include "SimpleTest.h"
+using namespace std;
+
+FlatMaze::FlatMaze() {
+    _numRows = 0;
+    _numCols = 0;
+    _wordsPerRow = 0;
+    _bits = nullptr;
+}
+
+FlatMaze::FlatMaze(const Grid<bool>& maze) {
+    resize(maze.numRows(), maze.numCols());
+    for (int r = 0; r < _numRows; r++) {
+        for (int c = 0; c < _numCols; c++) {
+            if (maze[r][c])
+                setOpen(r, c, true);
+        }
+    }
+}
+
+FlatMaze::FlatMaze(const FlatMaze& other) {
+    _numRows = other._numRows;
+    _numCols = other._numCols;
+    _wordsPerRow = other._wordsPerRow;
+    _storage.assign(other._bits, other._bits + other.numWords());
+    _bits = _storage.data();
+}
+
+FlatMaze::FlatMaze(FlatMaze&& other) : FlatMaze() {
+    swapWith(other);
+}
+
+FlatMaze& FlatMaze::operator=(FlatMaze other) {
+    swapWith(other);
+    return *this;
+}
+
+void FlatMaze::swapWith(FlatMaze& other) {
+    std::swap(_numRows, other._numRows);
+    std::swap(_numCols, other._numCols);
+    std::swap(_wordsPerRow, other._wordsPerRow);
+    std::swap(_bits, other._bits);      // swapping vectors keeps their buffers
+    _storage.swap(other._storage);
+    _owner.swap(other._owner);
+}
+
+void FlatMaze::resize(int numRows, int numCols) {
+    if (numRows < 0 || numCols < 0)
+        error("FlatMaze dimensions cannot be negative");
+    int wordsPerRow = (numCols + 2 + 63) / 64;  // room for left and right border
+    if (uint64_t(numRows + 2) * wordsPerRow * 64 >= NO_CELL)
+        error("FlatMaze is too large to index with 32 bits");
+    _numRows = numRows;
+    _numCols = numCols;
+    _wordsPerRow = wordsPerRow;
+    _storage.assign(size_t(numRows + 2) * wordsPerRow, 0);
+    _bits = _storage.data();
+    _owner.reset();
+}
+
+void FlatMaze::attach(int numRows, int numCols, uint64_t* words, shared_ptr<void> owner) {
+    vector<uint64_t>().swap(_storage);
+    _numRows = numRows;
+    _numCols = numCols;
+    _wordsPerRow = (numCols + 2 + 63) / 64;
+    _bits = words;
+    _owner = owner;
+}
+
+int FlatMaze::numRows() const {
+    return _numRows;
+}
+
+int FlatMaze::numCols() const {
+    return _numCols;
+}
+
+uint32_t FlatMaze::numIndices() const {
+    return uint32_t(_numRows + 2) * stride();
+}
+
+uint32_t FlatMaze::index(int row, int col) const {
+    return uint32_t(row + 1) * stride() + col + 1;
+}
+
+GridLocation FlatMaze::location(uint32_t index) const {
+    return {int(index / stride()) - 1, int(index % stride()) - 1};
+}
+
+bool FlatMaze::isOpen(int row, int col) const {
+    return isOpen(index(row, col));
+}
+
+void FlatMaze::setOpen(int row, int col, bool open) {
+    uint32_t i = index(row, col);
+    uint64_t mask = uint64_t(1) << (i & 63);
+    if (open)
+        _bits[i >> 6] |= mask;
+    else
+        _bits[i >> 6] &= ~mask;
+}
+
+GridLocation moveLocation(GridLocation loc, int bit) {
+    switch (bit) {
+        case MOVE_UP: return {loc.row - 1, loc.col};
+        case MOVE_LEFT: return {loc.row, loc.col - 1};
+        case MOVE_RIGHT: return {loc.row, loc.col + 1};
+        default: return {loc.row + 1, loc.col};
+    }
+}
+
+int moveBetween(GridLocation from, GridLocation to) {
+    int dr = to.row - from.row, dc = to.col - from.col;
+    if (dr == -1 && dc == 0) return MOVE_UP;
+    if (dr == 0 && dc == -1) return MOVE_LEFT;
+    if (dr == 0 && dc == 1) return MOVE_RIGHT;
+    if (dr == 1 && dc == 0) return MOVE_DOWN;
+    return 0;
+}
+
+/*
+ * FIFO queue of cell indices in a power-of-two ring buffer that doubles
+ * when full.
+ */
+class IndexRing {
+public:
+    IndexRing(uint32_t capacity) {
+        uint32_t size = 16;
+        while (size < capacity)
+            size *= 2;
+        _buf.resize(size);
+        _mask = size - 1;
+        _head = _tail = 0;
+    }
+    bool isEmpty() const {
+        return _head == _tail;
+    }
+    void enqueue(uint32_t index) {
+        if (_tail - _head == _buf.size())
+            grow();
+        _buf[_tail++ & _mask] = index;
+    }
+    uint32_t dequeue() {
+        return _buf[_head++ & _mask];
+    }
+
+private:
+    vector<uint32_t> _buf;
+    uint32_t _mask;
+    uint32_t _head, _tail;   // free-running counters, wrapped by _mask
+
+    void grow() {
+        vector<uint32_t> bigger(_buf.size() * 2);
+        uint32_t n = _tail - _head;
+        for (uint32_t i = 0; i < n; i++) {
+            bigger[i] = _buf[(_head + i) & _mask];
+        }
+        _buf.swap(bigger);
+        _mask = _buf.size() - 1;
+        _head = 0;
+        _tail = n;
+    }
+};
+
+Vector<GridLocation> solveMazeFlatBFS(const FlatMaze& maze, long& expanded) {
+    Vector<GridLocation> path;
+    expanded = 0;
+    if (maze.numRows() == 0 || maze.numCols() == 0)
+        return path;
+    uint32_t entry = maze.index(0, 0);
+    uint32_t exit = maze.index(maze.numRows() - 1, maze.numCols() - 1);
+    if (!maze.isOpen(entry) || !maze.isOpen(exit))
+        return path;
+
+    // unvisited holds the open cells not yet reached, so the inner loop
+    // tests one bit instead of loading from the much larger parent array
+    FlatMaze unvisited = maze;
+    vector<uint32_t> parent(maze.numIndices(), NO_CELL);
+    IndexRing queue(maze.numRows() + maze.numCols());
+    parent[entry] = entry;
+    unvisited.clearCell(entry);
+    queue.enqueue(entry);
+
+    while (!queue.isEmpty() && parent[exit] == NO_CELL) {
+        uint32_t cur = queue.dequeue();
+        expanded++;
+        int moves = unvisited.neighborMask(cur);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            if (moves & bit) {
+                uint32_t nb = cur + maze.moveOffset(bit);
+                unvisited.clearCell(nb);
+                parent[nb] = cur;
+                queue.enqueue(nb);
+            }
+        }
+    }
+
+    if (parent[exit] == NO_CELL)
+        return path;
+    // walk the parent chain once to size the path, then fill it back to front
+    int length = 1;
+    for (uint32_t cur = exit; cur != entry; cur = parent[cur]) {
+        length++;
+    }
+    path = Vector<GridLocation>(length);
+    int i = length - 1;
+    for (uint32_t cur = exit; cur != entry; cur = parent[cur]) {
+        path[i--] = maze.location(cur);
+    }
+    path[0] = maze.location(entry);
+    return path;
+}
+
+Vector<GridLocation> solveMazeFlatBFS(const FlatMaze& maze) {
+    long expanded;
+    return solveMazeFlatBFS(maze, expanded);
+}
+
+Vector<GridLocation> solveMazeFlatBFS(Grid<bool>& maze) {
+    return solveMazeFlatBFS(FlatMaze(maze));
+}
+
+Vector<GridLocation> pathFromDistances(const FlatMaze& maze, const vector<uint32_t>& dist, uint32_t cell) {
+    Vector<GridLocation> path(dist[cell] + 1);
+    for (int i = dist[cell]; i > 0; i--) {
+        path[i] = maze.location(cell);
+        int moves = maze.neighborMask(cell);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            uint32_t nb = cell + maze.moveOffset(bit);
+            if ((moves & bit) && dist[nb] == dist[cell] - 1) {
+                cell = nb;
+                break;
+            }
+        }
+    }
+    path[0] = maze.location(cell);
+    return path;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper that builds an n x n maze of horizontal corridors joined by
+ * gaps at alternating ends, so the only path snakes through every row. */
+static FlatMaze serpentineMaze(int n) {
+    FlatMaze maze;
+    maze.resize(n, n);
+    for (int r = 0; r < n; r += 2) {
+        for (int c = 0; c < n; c++) {
+            maze.setOpen(r, c, true);
+        }
+        if (r + 1 < n)
+            maze.setOpen(r + 1, (r / 2) % 2 == 0 ? n - 1 : 0, true);
+    }
+    return maze;
+}
+
+STUDENT_TEST("FlatMaze stores cells as bits") {
+    Grid<bool> grid = {{true, false, true},
+                       {true, true, false}};
+    FlatMaze maze(grid);
+    EXPECT_EQUAL(maze.numRows(), 2);
+    EXPECT_EQUAL(maze.numCols(), 3);
+    EXPECT_EQUAL(maze.stride(), 64);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 3; c++) {
+            EXPECT_EQUAL(maze.isOpen(r, c), grid[r][c]);
+            EXPECT_EQUAL(maze.location(maze.index(r, c)), GridLocation(r, c));
+        }
+    }
+    EXPECT_EQUAL(FlatMaze(Grid<bool>(3, 62)).stride(), 64);
+    EXPECT_EQUAL(FlatMaze(Grid<bool>(3, 63)).stride(), 128);
+}
+
+STUDENT_TEST("FlatMaze neighborMask sees the wall border") {
+    Grid<bool> grid = {{true, true, true},
+                       {true, false, true},
+                       {true, true, true}};
+    FlatMaze maze(grid);
+    EXPECT_EQUAL(maze.neighborMask(maze.index(0, 0)), MOVE_RIGHT | MOVE_DOWN);
+    EXPECT_EQUAL(maze.neighborMask(maze.index(0, 1)), MOVE_LEFT | MOVE_RIGHT);
+    EXPECT_EQUAL(maze.neighborMask(maze.index(1, 1)), MOVE_UP | MOVE_LEFT | MOVE_RIGHT | MOVE_DOWN);
+    EXPECT_EQUAL(maze.neighborMask(maze.index(2, 2)), MOVE_UP | MOVE_LEFT);
+    uint32_t center = maze.index(1, 1);
+    EXPECT_EQUAL(center + maze.moveOffset(MOVE_UP), maze.index(0, 1));
+    EXPECT_EQUAL(center + maze.moveOffset(MOVE_DOWN), maze.index(2, 1));
+}
+
+STUDENT_TEST("solveMazeFlatBFS finds shortest paths on maze files") {
+    Vector<string> files = {"res/5x7.maze", "res/13x39.maze", "res/21x23.maze", "res/33x41.maze"};
+    for (string file : files) {
+        Grid<bool> maze;
+        readMazeFile(file, maze);
+        Vector<GridLocation> path = solveMazeFlatBFS(maze);
+        EXPECT_NO_ERROR(validatePath(maze, path));
+        EXPECT_EQUAL(path.size(), solveMazeBFS(maze).size());
+    }
+}
+
+STUDENT_TEST("solveMazeFlatBFS on small and unsolvable mazes") {
+    Grid<bool> one = {{true}};
+    EXPECT_EQUAL(solveMazeFlatBFS(one), {{0, 0}});
+
+    Grid<bool> maze = {{true, false, true},
+                       {true, true, true}};
+    Vector<GridLocation> sol = { {0,0}, {1,0}, {1,1}, {1,2} };
+    EXPECT_EQUAL(solveMazeFlatBFS(maze), sol);
+
+    Grid<bool> blocked = {{true, false},
+                          {false, true}};
+    EXPECT(solveMazeFlatBFS(blocked).isEmpty());
+}
+
+STUDENT_TEST("solveMazeFlatBFS on large serpentine mazes") {
+    int n = 1001;
+    FlatMaze maze = serpentineMaze(n);
+    Vector<GridLocation> path;
+    TIME_OPERATION(n * n, path = solveMazeFlatBFS(maze));
+    EXPECT_EQUAL(path.size(), (n + 1) / 2 * n + n / 2);
+
+//    int n2 = 10001;
+//    FlatMaze maze2 = serpentineMaze(n2);
+//    TIME_OPERATION(n2 * n2, solveMazeFlatBFS(maze2));
+}
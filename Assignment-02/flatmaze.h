@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "grid.h"
+#include "vector.h"
+
+/*
+ * Directions in the order generateValidMoves lists neighbors, and the bit
+ * each one uses in a neighbor mask.
+ */
+enum MoveBit { MOVE_UP = 1, MOVE_LEFT = 2, MOVE_RIGHT = 4, MOVE_DOWN = 8 };
+
+/**
+ * Compact maze for solving large grids. Each cell is one bit (1 = open
+ * corridor, 0 = wall) and each row starts on a 64-bit word boundary. A
+ * cell is addressed by a flat index, which solvers use in place of
+ * GridLocation so per-cell state fits in flat arrays.
+ *
+ * The stored grid is padded with a one-cell wall border on every side.
+ * Every real cell therefore has four in-range neighbors, and its open
+ * neighbors can be read as a 4-bit mask with no bounds checks.
+ */
+class FlatMaze {
+public:
+    /**
+     * Creates an empty 0x0 maze.
+     */
+    FlatMaze();
+
+    /**
+     * Creates a maze with the same dimensions and corridors as a Grid<bool>.
+     */
+    explicit FlatMaze(const Grid<bool>& maze);
+
+    /**
+     * Copies always own their cells, even when the original uses memory
+     * attached with attach().
+     */
+    FlatMaze(const FlatMaze& other);
+    FlatMaze(FlatMaze&& other);
+    FlatMaze& operator=(FlatMaze other);
+
+    /**
+     * Resets the maze to the given dimensions with every cell a wall.
+     */
+    void resize(int numRows, int numCols);
+
+    /**
+     * Makes the maze use words, already in the layout described at words(),
+     * in place of storage of its own, e.g. a memory-mapped file. owner is
+     * held for as long as the maze uses the words, and is released on the
+     * next resize() or attach().
+     */
+    void attach(int numRows, int numCols, uint64_t* words, std::shared_ptr<void> owner);
+
+    int numRows() const;
+    int numCols() const;
+
+    /*
+     * Distance between vertically adjacent cells in index space.
+     */
+    uint32_t stride() const {
+        return uint32_t(_wordsPerRow) * 64;
+    }
+
+    /*
+     * One past the largest cell index, border included, for sizing
+     * per-cell arrays.
+     */
+    uint32_t numIndices() const;
+
+    uint32_t index(int row, int col) const;
+    GridLocation location(uint32_t index) const;
+
+    bool isOpen(int row, int col) const;
+    void setOpen(int row, int col, bool open);
+
+    bool isOpen(uint32_t index) const {
+        return (_bits[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void clearCell(uint32_t index) {
+        _bits[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    }
+
+    /*
+     * Raw bit rows for word-at-a-time algorithms: padded row r (0 and
+     * numRows() + 1 are the border) starts at words()[r * wordsPerRow()],
+     * and cell index i is bit i & 63 of word i >> 6.
+     */
+    int wordsPerRow() const {
+        return _wordsPerRow;
+    }
+
+    const uint64_t* words() const {
+        return _bits;
+    }
+
+    uint64_t* words() {
+        return _bits;
+    }
+
+    size_t numWords() const {
+        return size_t(_numRows + 2) * _wordsPerRow;
+    }
+
+    /*
+     * Returns the MoveBits of the open neighbors of a cell.
+     */
+    int neighborMask(uint32_t index) const {
+        uint32_t s = stride();
+        return int(isOpen(index - s))
+             | int(isOpen(index - 1)) << 1
+             | int(isOpen(index + 1)) << 2
+             | int(isOpen(index + s)) << 3;
+    }
+
+    /*
+     * Index distance to the neighbor in direction bit (one of the MoveBits).
+     */
+    int32_t moveOffset(int bit) const {
+        switch (bit) {
+            case MOVE_UP: return -int32_t(stride());
+            case MOVE_LEFT: return -1;
+            case MOVE_RIGHT: return 1;
+            default: return int32_t(stride());
+        }
+    }
+
+private:
+    int _numRows;
+    int _numCols;
+    int _wordsPerRow;
+    uint64_t* _bits;                    // _storage.data(), or attached memory
+    std::vector<uint64_t> _storage;
+    std::shared_ptr<void> _owner;       // keeps attached memory alive
+
+    void swapWith(FlatMaze& other);
+};
+
+/*
+ * Returns the location one step from loc in direction bit.
+ */
+GridLocation moveLocation(GridLocation loc, int bit);
+
+/*
+ * Rebuilds a path from the entry to cell, given each visited cell's
+ * distance from the entry (NO_CELL if unvisited): every step goes to a
+ * neighbor one closer, so no parent pointers are needed.
+ */
+Vector<GridLocation> pathFromDistances(const FlatMaze& maze, const std::vector<uint32_t>& dist, uint32_t cell);
+
+/*
+ * Returns the MoveBit that steps from one location to the other, or 0 if
+ * they are not orthogonally adjacent.
+ */
+int moveBetween(GridLocation from, GridLocation to);
+
+/*
+ * Sentinel index meaning "no cell", e.g. an unvisited parent.
+ */
+const uint32_t NO_CELL = 0xFFFFFFFF;
+
+/*
+ * Finds a shortest path from the top left to the bottom right corner with a
+ * breadth-first search over cell indices. Visited state is a copy of the
+ * maze's bits with each cell cleared when it is reached, so expanding a
+ * cell reads one neighbor mask of the cells not yet reached. The search
+ * tree is a parent array indexed by cell, the frontier a ring buffer of
+ * indices, and the path is rebuilt from the parents once at the end.
+ * Returns an empty path if the exit cannot be reached. expanded is set to
+ * the number of cells dequeued.
+ */
+Vector<GridLocation> solveMazeFlatBFS(const FlatMaze& maze, long& expanded);
+Vector<GridLocation> solveMazeFlatBFS(const FlatMaze& maze);
+Vector<GridLocation> solveMazeFlatBFS(Grid<bool>& maze);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "error.h"
+#ifdef _WIN32
+// keep windows.h from defining min and max macros, which break std::min
+// and std::max in every file that includes this one
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * A whole file mapped into memory copy-on-write: writes through data()
+ * stay private to this process and never reach the file.
+ */
+class MappedFile {
+public:
+    MappedFile(std::string filename) {
+        _data = nullptr;
+        _size = 0;
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            error("Cannot open file named " + filename);
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        _size = size_t(size.QuadPart);
+        if (_size > 0) {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+            if (mapping != NULL) {
+                _data = (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            error("Cannot open file named " + filename);
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+            _size = size_t(info.st_size);
+        if (_size > 0) {
+            void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            _data = data == MAP_FAILED ? nullptr : (char*)data;
+        }
+        close(fd);
+#endif
+        if (_size > 0 && _data == nullptr)
+            error("Cannot map file named " + filename + " into memory");
+    }
+
+    ~MappedFile() {
+        if (_data == nullptr)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap(_data, _size);
+#endif
+    }
+
+    char* data() {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    char* _data;
+    size_t _size;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
@@ -4,10 +4,12 @@
  *  from the top left to bottom right corner, while avoiding walls.
  */
 
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include "error.h"
 #include "filelib.h"
+#include "flatmaze.h"
 #include "grid.h"
 #include "maze.h"
 #include "mazegraphics.h"
@@ -18,102 +20,83 @@
 #include "SimpleTest.h" // IWYU pragma: keep (needed to quiet spurious warning)
 using namespace std;
 
-// Takes in coordinates and determines if out of bounds or not.
-// Returns false if out of bounds or if maze at location is false.
-// Returnst true if location is true and within bounds.
-GridLocation validHelper(Grid<bool>& maze, GridLocation cur) {
-    const int ROWS = maze.numRows();
-    const int COLS = maze.numCols();
-
-    if (cur.row < 0 or cur.row >= ROWS or cur.col < 0 or cur.col >= COLS)
-        return {-1,-1};  // out of bounds
-    else if (maze[cur.row][cur.col] == true)
-        return cur;
-    else
-        return {-1, -1};  // false
-}
-
-// Takes in coordinates and passes neighboring squares to helper function.
-// If neighbor is valid path, adds location to set.
+// Takes in coordinates and adds each neighboring square that is
+// within bounds and an open corridor to a set.
 Set<GridLocation> generateValidMoves(Grid<bool>& maze, GridLocation cur) {
     Set<GridLocation> neighbors;
-    const int ROWS = maze.numRows();
-    const int COLS = maze.numCols();
-    GridLocation invalid = {-1,-1};
-
-    if (!(validHelper(maze, {cur.row-1, cur.col}) == invalid))
-        neighbors.add({cur.row-1, cur.col});
-    if (!(validHelper(maze, {cur.row+1, cur.col}) == invalid))
-        neighbors.add({cur.row+1, cur.col});
-    if (!(validHelper(maze, {cur.row, cur.col+1}) == invalid))
-        neighbors.add({cur.row, cur.col+1});
-    if (!(validHelper(maze, {cur.row, cur.col-1}) == invalid))
-        neighbors.add({cur.row, cur.col-1});
-
+    for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+        GridLocation next = moveLocation(cur, bit);
+        if (maze.inBounds(next) && maze[next])
+            neighbors.add(next);
+    }
     return neighbors;
 }
 
 // Confirm maze path by validating path is not empty, starts at top left
 // and ends at bottom right, paths are not repeated, and path does not
-// contain a loop.
+// contain a loop. The maze is copied into a FlatMaze of bits, and each
+// cell's bit is cleared when the path visits it, so each step is one bit
+// test and the copy costs one bit per cell. PathValidator has the same
+// rules for checking many paths against one maze.
 void validatePath(Grid<bool>& maze, Vector<GridLocation>& path) {
-    if (path.isEmpty()) {
+    if (path.isEmpty())
         error("Path is empty!");
-    }
-
-    GridLocation start = {0,0};
-    GridLocation end = {maze.numRows() - 1, maze.numCols() - 1};
-    Set<GridLocation> visited;
-
-    if (!(path.get(0) == start)) {
+    int rows = maze.numRows(), cols = maze.numCols();
+    GridLocation first = path[0], last = path[path.size() - 1];
+    if (first.row != 0 || first.col != 0)
         error("Doesn't start top left.");
-    }
-    if (!((path.get(path.size() - 1)) == end)) {
+    if (last.row != rows - 1 || last.col != cols - 1)
         error("Doesn't end in bottom left.");
-    }
 
-    visited.add(path.get(0));
-
-    for (int i = 0; i < path.size() - 1; i++) {
-        Set<GridLocation> valid = generateValidMoves(maze, path[i]);
-        if (!(valid.contains(path[i+1])))
+    FlatMaze unvisited(maze);
+    unvisited.clearCell(unvisited.index(0, 0));
+    for (int i = 1; i < path.size(); i++) {
+        GridLocation prev = path[i - 1], cur = path[i];
+        // one step in one direction, onto an open cell inside the maze
+        if (abs(cur.row - prev.row) + abs(cur.col - prev.col) != 1 || !maze.inBounds(cur))
             error("Invalid path");
-        if (visited.contains(path[i+1]))
-            error("Already visited");
-        visited.add(path[i+1]);
+        uint32_t index = unvisited.index(cur.row, cur.col);
+        if (!unvisited.isOpen(index))
+            error(maze[cur] ? "Already visited" : "Invalid path");
+        unvisited.clearCell(index);
     }
 }
 
 // Finds a valid maze path by adding possible paths to a queue,
 // then popping the front of the queue and adding more valid locations.
 // Paths are added in order from the entry (top left) to the exit (bototm right).
-Vector<GridLocation> solveMazeBFS(Grid<bool>& maze) {
+// Unvisited open cells are tracked as bits of a padded maze, so expanding
+// a cell reads one neighbor mask instead of allocating a set.
+Vector<GridLocation> searchMazeBFS(Grid<bool>& maze, long& expanded) {
     Vector<GridLocation> path;
     Queue<Vector<GridLocation>> allPaths;
 
-    drawMaze(maze);
     Vector<GridLocation> curr;
     GridLocation entry = {0, 0};
     GridLocation exit = {maze.numRows() - 1, maze.numCols() - 1};
     path.add(entry);
 
-    Set<GridLocation> visited;
-    visited.add(entry);
+    FlatMaze unvisited(maze);
+    unvisited.clearCell(unvisited.index(entry.row, entry.col));
 
     allPaths.enqueue(path);
+    expanded = 0;
 
     while (!allPaths.isEmpty()) {
         curr = allPaths.dequeue();
-        if (curr[curr.size() - 1] == exit) { // found exit. return path
+        expanded++;
+        GridLocation last = curr[curr.size() - 1];
+        if (last == exit) { // found exit. return path
             return curr;
         }
-        Set<GridLocation> moves = generateValidMoves(maze, curr[curr.size() - 1]);
-        for (GridLocation loc : moves) {
-            if (!visited.contains(loc)) {
-                curr.add(loc);
+        uint32_t cell = unvisited.index(last.row, last.col);
+        int moves = unvisited.neighborMask(cell);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            if (moves & bit) {
+                unvisited.clearCell(cell + unvisited.moveOffset(bit));
+                curr.add(moveLocation(last, bit));
                 allPaths.enqueue(curr);
                 curr.remove(curr.size() - 1);
-                visited.add(loc);
             }
         }
     }
@@ -121,36 +104,45 @@ Vector<GridLocation> solveMazeBFS(Grid<bool>& maze) {
     return path;
 }
 
+Vector<GridLocation> solveMazeBFS(Grid<bool>& maze) {
+    long expanded;
+    drawMaze(maze);
+    return searchMazeBFS(maze, expanded);
+}
+
 // Finds a valid maze path by exploring a single path to its fullest
 // depth before moving onto other paths if unsuccessful. Uses a stack
 // to push and remove potential paths.
-Vector<GridLocation> solveMazeDFS(Grid<bool>& maze) {
+Vector<GridLocation> searchMazeDFS(Grid<bool>& maze, long& expanded) {
     Vector<GridLocation> path;
     Stack<Vector<GridLocation>> allPaths;
 
-    drawMaze(maze);
     Vector<GridLocation> curr;
     GridLocation entry = {0, 0};
     GridLocation exit = {maze.numRows() - 1, maze.numCols() - 1};
     path.add(entry);
 
-    Set<GridLocation> visited;
-    visited.add(entry);
+    FlatMaze unvisited(maze);
+    unvisited.clearCell(unvisited.index(entry.row, entry.col));
 
     allPaths.push(path);
+    expanded = 0;
 
     while (!allPaths.isEmpty()) {
         curr = allPaths.pop();
-        if (curr[curr.size() - 1] == exit) { // found exit. return path
+        expanded++;
+        GridLocation last = curr[curr.size() - 1];
+        if (last == exit) { // found exit. return path
             return curr;
         }
-        Set<GridLocation> moves = generateValidMoves(maze, curr[curr.size() - 1]);
-        for (GridLocation loc : moves) {
-            if (!visited.contains(loc)) {
-                curr.add(loc);
+        uint32_t cell = unvisited.index(last.row, last.col);
+        int moves = unvisited.neighborMask(cell);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            if (moves & bit) {
+                unvisited.clearCell(cell + unvisited.moveOffset(bit));
+                curr.add(moveLocation(last, bit));
                 allPaths.push(curr);
                 curr.remove(curr.size() - 1);
-                visited.add(loc);
             }
         }
     }
@@ -158,6 +150,12 @@ Vector<GridLocation> solveMazeDFS(Grid<bool>& maze) {
     return path;
 }
 
+Vector<GridLocation> solveMazeDFS(Grid<bool>& maze) {
+    long expanded;
+    drawMaze(maze);
+    return searchMazeDFS(maze, expanded);
+}
+
 /*
  * The given readMazeFile function correctly reads a well-formed
  * maze from a file.
@@ -16,3 +16,8 @@ void readSolutionFile(std::string filename, Vector<GridLocation>& soln);
 
 Vector<GridLocation> solveMazeBFS(Grid<bool>& maze);
 Vector<GridLocation> solveMazeDFS(Grid<bool>& maze);
+
+// The searches behind solveMazeBFS/DFS, without drawing the maze.
+// expanded is set to the number of paths taken off the queue/stack.
+Vector<GridLocation> searchMazeBFS(Grid<bool>& maze, long& expanded);
+Vector<GridLocation> searchMazeDFS(Grid<bool>& maze, long& expanded);
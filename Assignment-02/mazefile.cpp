@@ -0,0 +1,284 @@
+/*
+ * Fast maze file input and output for mazes too large for the
+ * line-by-line readMazeFile in maze.cpp.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "error.h"
+#include "filelib.h"
+#include "mappedfile.h"
+#include "maze.h"
+#include "mazefile.h"
+#include "mazegen.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+static const char MAZE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'B', 'I', 'N', '1'};
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct MazeFileHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t numRows;
+    uint32_t numCols;
+    uint32_t wordsPerRow;
+    uint64_t reserved;
+};
+
+void writeMazeBinary(const FlatMaze& maze, string filename) {
+    MazeFileHeader header;
+    memcpy(header.magic, MAZE_MAGIC, sizeof(MAZE_MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numRows = maze.numRows();
+    header.numCols = maze.numCols();
+    header.wordsPerRow = maze.wordsPerRow();
+    header.reserved = 0;
+
+    ofstream out(filename, ios::binary);
+    if (!out)
+        error("Cannot open file named " + filename);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)maze.words(), maze.numWords() * sizeof(uint64_t));
+    if (!out)
+        error("Error writing maze file " + filename);
+}
+
+/*
+ * Uses the mapped words of a binary maze file as the cells of maze, after
+ * checking the header and that the wall border is intact: the solvers
+ * depend on it to skip bounds checks.
+ */
+static void attachBinaryMaze(shared_ptr<MappedFile> file, string filename, FlatMaze& maze) {
+    MazeFileHeader header;
+    if (file->size() < sizeof(header))
+        error("Maze file " + filename + " is too short for its header");
+    memcpy(&header, file->data(), sizeof(header));
+    if (header.byteOrder != BYTE_ORDER_MARK)
+        error("Maze file " + filename + " was written with a different byte order");
+    uint64_t rows = header.numRows, cols = header.numCols, W = header.wordsPerRow;
+    if (W != (cols + 2 + 63) / 64 || (rows + 2) * W * 64 >= NO_CELL)
+        error("Maze file " + filename + " has an invalid header");
+    if (file->size() != sizeof(header) + (rows + 2) * W * sizeof(uint64_t))
+        error("Maze file " + filename + " is truncated or has extra data");
+
+    uint64_t* words = (uint64_t*)(file->data() + sizeof(header));
+    bool borderIntact = true;
+    for (uint64_t w = 0; w < W; w++) {
+        borderIntact &= words[w] == 0 && words[(rows + 1) * W + w] == 0;
+    }
+    for (uint64_t r = 1; r <= rows; r++) {
+        uint64_t* row = words + r * W;
+        borderIntact &= (row[0] & 1) == 0 && (row[(cols + 1) / 64] >> ((cols + 1) % 64)) == 0;
+        for (uint64_t w = (cols + 1) / 64 + 1; w < W; w++) {
+            borderIntact &= row[w] == 0;
+        }
+    }
+    if (!borderIntact)
+        error("Maze file " + filename + " has open cells in its border");
+    maze.attach(int(rows), int(cols), words, file);
+}
+
+/*
+ * Sets the bits of one padded row from a line of '@' and '-' characters.
+ * Each 64 characters become one 64-bit mask, which lands in the row
+ * shifted one place for the left border. Returns the column of the first
+ * character that is neither, or -1.
+ */
+static int convertRow(const char* line, int cols, uint64_t* row) {
+    int c = 0;
+    for (; c + 64 <= cols; c += 64) {
+        uint64_t open = 0, valid = 0;
+#ifdef __SSE2__
+        for (int k = 0; k < 4; k++) {
+            __m128i chars = _mm_loadu_si128((const __m128i*)(line + c + 16 * k));
+            __m128i corridor = _mm_cmpeq_epi8(chars, _mm_set1_epi8('-'));
+            __m128i wall = _mm_cmpeq_epi8(chars, _mm_set1_epi8('@'));
+            open |= uint64_t(uint32_t(_mm_movemask_epi8(corridor))) << (16 * k);
+            valid |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_or_si128(corridor, wall)))) << (16 * k);
+        }
+#else
+        for (int k = 0; k < 64; k++) {
+            open |= uint64_t(line[c + k] == '-') << k;
+            valid |= uint64_t(line[c + k] == '-' || line[c + k] == '@') << k;
+        }
+#endif
+        if (valid != ~uint64_t(0))
+            break;      // the loop below finds the bad character
+        row[c / 64] |= open << 1;
+        row[c / 64 + 1] |= open >> 63;
+    }
+    for (; c < cols; c++) {
+        if (line[c] == '-')
+            row[(c + 1) / 64] |= uint64_t(1) << ((c + 1) % 64);
+        else if (line[c] != '@')
+            return c;
+    }
+    return -1;
+}
+
+/*
+ * Returns the length of the line starting at text, not counting its line
+ * ending, and sets next to the start of the following line.
+ */
+static size_t lineLength(const char* text, const char* end, const char*& next) {
+    const char* newline = (const char*)memchr(text, '\n', end - text);
+    next = newline ? newline + 1 : end;
+    const char* stop = newline ? newline : end;
+    if (stop > text && stop[-1] == '\r')
+        stop--;
+    return stop - text;
+}
+
+static void parseTextMaze(const char* text, size_t size, string filename, FlatMaze& maze) {
+    if (size == 0)
+        error("Maze file " + filename + " is empty");
+    const char* end = text + size;
+    const char* next;
+    int numCols = int(lineLength(text, end, next));
+    if (numCols == 0)
+        error("Maze file " + filename + " is empty");
+    int numRows = 0;
+    for (const char* line = text; line < end; line = next) {
+        lineLength(line, end, next);
+        numRows++;
+    }
+    maze.resize(numRows, numCols);
+
+    const char* line = text;
+    for (int r = 0; r < numRows; r++, line = next) {
+        if (int(lineLength(line, end, next)) != numCols)
+            error("Maze row has inconsistent number of columns");
+        int bad = convertRow(line, numCols, maze.words() + size_t(r + 1) * maze.wordsPerRow());
+        if (bad >= 0)
+            error("Maze location has invalid character: '" + charToString(line[bad]) + "'");
+    }
+}
+
+void readMazeFile(string filename, FlatMaze& maze) {
+    shared_ptr<MappedFile> file = make_shared<MappedFile>(filename);
+    if (file->size() >= sizeof(MAZE_MAGIC) && memcmp(file->data(), MAZE_MAGIC, sizeof(MAZE_MAGIC)) == 0)
+        attachBinaryMaze(file, filename, maze);
+    else
+        parseTextMaze(file->data(), file->size(), filename, maze);
+}
+
+void convertMazeFile(string textFile, string binaryFile) {
+    FlatMaze maze;
+    readMazeFile(textFile, maze);
+    writeMazeBinary(maze, binaryFile);
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper that replaces the contents of a file with bytes. */
+static void writeBytes(string filename, string bytes) {
+    ofstream out(filename, ios::binary);
+    out << bytes;
+}
+
+/* Test helper that checks a FlatMaze has the same cells as a Grid<bool>. */
+static bool sameCells(const FlatMaze& flat, const Grid<bool>& grid) {
+    if (flat.numRows() != grid.numRows() || flat.numCols() != grid.numCols())
+        return false;
+    for (int r = 0; r < grid.numRows(); r++) {
+        for (int c = 0; c < grid.numCols(); c++) {
+            if (flat.isOpen(r, c) != grid[r][c])
+                return false;
+        }
+    }
+    return true;
+}
+
+STUDENT_TEST("readMazeFile into FlatMaze matches the Grid<bool> reader") {
+    for (string file : {"res/2x2.maze", "res/5x7.maze", "res/13x39.maze", "res/33x41.maze"}) {
+        Grid<bool> grid;
+        FlatMaze flat;
+        readMazeFile(file, grid);
+        readMazeFile(file, flat);
+        EXPECT(sameCells(flat, grid));
+    }
+}
+
+STUDENT_TEST("Binary maze files round trip through text and binary") {
+    // widths around the 64-column word boundaries
+    for (int cols : {1, 62, 63, 64, 65, 127, 128, 200}) {
+        FlatMaze generated, fromText, fromBinary;
+        generateMaze(GEN_KRUSKAL, 9, cols, cols, generated);
+        writeMazeFile(generated, "res/roundtrip.maze");
+        convertMazeFile("res/roundtrip.maze", "res/roundtrip.mazebin");
+        readMazeFile("res/roundtrip.maze", fromText);
+        readMazeFile("res/roundtrip.mazebin", fromBinary);
+        Grid<bool> expected;
+        generateMaze(GEN_KRUSKAL, 9, cols, cols, expected);
+        EXPECT(sameCells(fromText, expected));
+        EXPECT(sameCells(fromBinary, expected));
+        EXPECT_EQUAL(solveMazeFlatBFS(fromBinary).size(), solveMazeFlatBFS(generated).size());
+    }
+
+    // changes to a mapped maze stay private to it
+    FlatMaze mapped, again;
+    readMazeFile("res/roundtrip.mazebin", mapped);
+    mapped.setOpen(0, 0, false);
+    readMazeFile("res/roundtrip.mazebin", again);
+    EXPECT(again.isOpen(0, 0));
+    deleteFile("res/roundtrip.maze");
+    deleteFile("res/roundtrip.mazebin");
+}
+
+STUDENT_TEST("readMazeFile into FlatMaze rejects malformed files") {
+    FlatMaze maze;
+    EXPECT_ERROR(readMazeFile("res/no-such-file.maze", maze));
+
+    writeBytes("res/bad.maze", "");
+    EXPECT_ERROR(readMazeFile("res/bad.maze", maze));
+    writeBytes("res/bad.maze", "--@-\n--x-\n");
+    EXPECT_ERROR(readMazeFile("res/bad.maze", maze));
+    writeBytes("res/bad.maze", "--@-\n---\n");
+    EXPECT_ERROR(readMazeFile("res/bad.maze", maze));
+    writeBytes("res/bad.maze", string(100, '-') + "\r\n" + string(99, '@') + "#\r\n");
+    EXPECT_ERROR(readMazeFile("res/bad.maze", maze));
+    writeBytes("res/bad.maze", string(100, '-') + "\r\n" + string(100, '@') + "\r\n");
+    EXPECT_NO_ERROR(readMazeFile("res/bad.maze", maze));
+    EXPECT_EQUAL(maze.numRows(), 2);
+    EXPECT_EQUAL(maze.numCols(), 100);
+
+    // a binary file cut short, and one whose wall border was opened
+    FlatMaze generated;
+    generateMaze(GEN_OPEN_ROOMS, 20, 20, 1, generated);
+    writeMazeBinary(generated, "res/bad.mazebin");
+    ifstream in("res/bad.mazebin", ios::binary);
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    writeBytes("res/bad.mazebin", bytes.substr(0, bytes.size() - 8));
+    EXPECT_ERROR(readMazeFile("res/bad.mazebin", maze));
+    bytes[32] = 1;
+    writeBytes("res/bad.mazebin", bytes);
+    EXPECT_ERROR(readMazeFile("res/bad.mazebin", maze));
+    deleteFile("res/bad.maze");
+    deleteFile("res/bad.mazebin");
+}
+
+STUDENT_TEST("Time reading a large maze as text, converted text and binary") {
+    int n = 2049;
+    FlatMaze generated;
+    generateMaze(GEN_WILSON, n, n, 34, generated);
+    writeMazeFile(generated, "res/large.maze");
+    writeMazeBinary(generated, "res/large.mazebin");
+
+    Grid<bool> grid;
+    FlatMaze flat;
+    TIME_OPERATION(n * n, readMazeFile("res/large.maze", grid));
+    TIME_OPERATION(n * n, readMazeFile("res/large.maze", flat));
+    EXPECT(sameCells(flat, grid));
+    TIME_OPERATION(n * n, readMazeFile("res/large.mazebin", flat));
+    EXPECT(sameCells(flat, grid));
+    deleteFile("res/large.maze");
+    deleteFile("res/large.mazebin");
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include "flatmaze.h"
+
+/*
+ * Binary maze files hold a FlatMaze exactly as it lies in memory, so a
+ * reader can map the file and use it without touching individual cells.
+ *
+ *     bytes  0-7    magic "MAZEBIN1"
+ *     bytes  8-11   0x01020304 in the writer's byte order
+ *     bytes 12-15   numRows
+ *     bytes 16-19   numCols
+ *     bytes 20-23   wordsPerRow
+ *     bytes 24-31   zero
+ *     bytes 32-     (numRows + 2) * wordsPerRow 64-bit words: the padded
+ *                   rows, wall border included
+ */
+
+/*
+ * Writes maze to filename in the binary format.
+ */
+void writeMazeBinary(const FlatMaze& maze, std::string filename);
+
+/*
+ * Reads a maze from either kind of maze file. A binary file is mapped into
+ * memory copy-on-write and used in place; only its header and the border
+ * bits at the ends of each row are checked. A text file in the format of
+ * readMazeFile is converted to bits 16 characters at a time with SSE2.
+ * Raises an error if the file is malformed.
+ */
+void readMazeFile(std::string filename, FlatMaze& maze);
+
+/*
+ * Converts a text maze file into a binary one.
+ */
+void convertMazeFile(std::string textFile, std::string binaryFile);
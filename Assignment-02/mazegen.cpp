@@ -0,0 +1,441 @@
+/*
+ * Procedural maze generators, used to produce mazes far larger than the
+ * ones in res/ for measuring how the solvers scale.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "error.h"
+#include "filelib.h"
+#include "maze.h"
+#include "mazegen.h"
+#include "mazesolve.h"
+#include "queue.h"
+#include "SimpleTest.h"
+using namespace std;
+
+string generatorName(MazeGenerator generator) {
+    switch (generator) {
+        case GEN_BACKTRACKER: return "backtracker";
+        case GEN_KRUSKAL: return "Kruskal";
+        case GEN_WILSON: return "Wilson";
+        case GEN_OPEN_ROOMS: return "open rooms";
+    }
+    return "unknown";
+}
+
+/*
+ * The perfect-maze generators work on a lattice of cells at even (row, col)
+ * of the maze. Joining two adjacent cells opens both of them and the wall
+ * cell between. Directions are numbered in MoveBit order, so the opposite
+ * of direction d is 3 - d.
+ */
+static const int DIR_ROW[4] = {-1, 0, 0, 1};
+static const int DIR_COL[4] = {0, -1, 1, 0};
+
+struct CellLattice {
+    FlatMaze* maze;
+    int rows, cols;         // cells down and across
+
+    uint32_t count() const {
+        return uint32_t(rows) * cols;
+    }
+    bool hasNeighbor(uint32_t cell, int dir) const {
+        int r = cell / cols + DIR_ROW[dir], c = cell % cols + DIR_COL[dir];
+        return r >= 0 && r < rows && c >= 0 && c < cols;
+    }
+    uint32_t neighbor(uint32_t cell, int dir) const {
+        return cell + DIR_ROW[dir] * cols + DIR_COL[dir];
+    }
+    bool isOpen(uint32_t cell) const {
+        return maze->isOpen(2 * int(cell / cols), 2 * int(cell % cols));
+    }
+    void open(uint32_t cell) {
+        maze->setOpen(2 * int(cell / cols), 2 * int(cell % cols), true);
+    }
+    void openWall(uint32_t cell, int dir) {
+        maze->setOpen(2 * int(cell / cols) + DIR_ROW[dir], 2 * int(cell % cols) + DIR_COL[dir], true);
+    }
+    void join(uint32_t cell, int dir) {
+        open(cell);
+        openWall(cell, dir);
+        open(neighbor(cell, dir));
+    }
+};
+
+/*
+ * Depth-first carving from the entry. Instead of an explicit stack, each
+ * cell remembers the direction back to the cell it was carved from.
+ */
+static void carveBacktracker(CellLattice& cells, mt19937& rng) {
+    vector<uint8_t> back(cells.count());
+    uint32_t cur = 0;
+    cells.open(cur);
+    while (true) {
+        int choices[4], numChoices = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            if (cells.hasNeighbor(cur, dir) && !cells.isOpen(cells.neighbor(cur, dir)))
+                choices[numChoices++] = dir;
+        }
+        if (numChoices == 0) {
+            if (cur == 0)
+                break;
+            cur = cells.neighbor(cur, back[cur]);
+            continue;
+        }
+        int dir = choices[rng() % numChoices];
+        cells.join(cur, dir);
+        cur = cells.neighbor(cur, dir);
+        back[cur] = 3 - dir;
+    }
+}
+
+/*
+ * A seeded pseudo-random permutation of [0, n) that is computed rather than
+ * stored, so Kruskal's algorithm can visit every wall in random order
+ * without a shuffled list of all of them. A Feistel network permutes the
+ * smallest power of four holding n; results outside [0, n) are fed back in
+ * until one lands inside, which keeps the mapping one-to-one.
+ */
+class RandomPermutation {
+public:
+    RandomPermutation(uint64_t n, mt19937& rng) {
+        _n = n;
+        _halfBits = 1;
+        while ((uint64_t(1) << (2 * _halfBits)) < n)
+            _halfBits++;
+        for (int i = 0; i < ROUNDS; i++) {
+            _keys[i] = uint64_t(rng()) << 32 | rng();
+        }
+    }
+
+    uint64_t operator[](uint64_t i) const {
+        do {
+            i = permute(i);
+        } while (i >= _n);
+        return i;
+    }
+
+private:
+    static const int ROUNDS = 4;
+    uint64_t _n;
+    int _halfBits;
+    uint64_t _keys[ROUNDS];
+
+    uint64_t permute(uint64_t x) const {
+        uint64_t mask = (uint64_t(1) << _halfBits) - 1;
+        uint64_t left = x >> _halfBits, right = x & mask;
+        for (int r = 0; r < ROUNDS; r++) {
+            uint64_t mixed = left ^ (scramble(right ^ _keys[r]) & mask);
+            left = right;
+            right = mixed;
+        }
+        return left << _halfBits | right;
+    }
+
+    static uint64_t scramble(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+};
+
+static uint32_t findRoot(vector<uint32_t>& parent, uint32_t cell) {
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]];    // path halving
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+/*
+ * Removes walls in random order, skipping any wall whose two cells are
+ * already connected. Walls are numbered with all the walls to the right
+ * of a cell first, then all the walls below one.
+ */
+static void carveKruskal(CellLattice& cells, mt19937& rng) {
+    vector<uint32_t> parent(cells.count());
+    for (uint32_t i = 0; i < parent.size(); i++) {
+        parent[i] = i;
+    }
+    uint64_t rightWalls = uint64_t(cells.rows) * (cells.cols - 1);
+    uint64_t numWalls = rightWalls + uint64_t(cells.rows - 1) * cells.cols;
+    RandomPermutation order(numWalls, rng);
+    cells.open(0);
+
+    uint32_t joined = 1;
+    for (uint64_t i = 0; i < numWalls && joined < cells.count(); i++) {
+        uint64_t wall = order[i];
+        uint32_t cell;
+        int dir;
+        if (wall < rightWalls) {
+            cell = uint32_t(wall / (cells.cols - 1) * cells.cols + wall % (cells.cols - 1));
+            dir = 2;
+        } else {
+            cell = uint32_t(wall - rightWalls);
+            dir = 3;
+        }
+        uint32_t a = findRoot(parent, cell), b = findRoot(parent, cells.neighbor(cell, dir));
+        if (a != b) {
+            parent[a] = b;
+            cells.join(cell, dir);
+            joined++;
+        }
+    }
+}
+
+/*
+ * Grows a tree from one random cell by adding loop-erased random walks:
+ * each walk starts from a cell not yet in the tree and ends on reaching
+ * the tree. Storing only the last direction taken from each cell erases
+ * loops for free, since revisiting a cell overwrites its exit.
+ */
+static void carveWilson(CellLattice& cells, mt19937& rng) {
+    vector<uint8_t> exitDir(cells.count());
+    cells.open(rng() % cells.count());
+    for (uint32_t start = 0; start < cells.count(); start++) {
+        uint32_t cur = start;
+        while (!cells.isOpen(cur)) {
+            int dir;
+            do {
+                dir = rng() & 3;
+            } while (!cells.hasNeighbor(cur, dir));
+            exitDir[cur] = dir;
+            cur = cells.neighbor(cur, dir);
+        }
+        for (cur = start; !cells.isOpen(cur); cur = cells.neighbor(cur, exitDir[cur])) {
+            cells.open(cur);
+            cells.openWall(cur, exitDir[cur]);
+        }
+    }
+}
+
+/*
+ * Chooses wall positions along one dimension, leaving rooms 7 to 23 cells
+ * wide. Neither the first nor the last position is a wall.
+ */
+static vector<bool> roomWalls(int size, mt19937& rng) {
+    vector<bool> wall(size, false);
+    for (int i = 7 + rng() % 17; i < size - 1; i += 8 + rng() % 17) {
+        wall[i] = true;
+    }
+    return wall;
+}
+
+/*
+ * Divides the maze into rooms and puts one door in every wall between two
+ * neighboring rooms, so every room is reachable.
+ */
+static void buildOpenRooms(FlatMaze& maze, mt19937& rng) {
+    int rows = maze.numRows(), cols = maze.numCols();
+    vector<bool> wallRow = roomWalls(rows, rng), wallCol = roomWalls(cols, rng);
+    for (int r = 0; r < rows; r++) {
+        if (wallRow[r])
+            continue;
+        for (int c = 0; c < cols; c++) {
+            if (!wallCol[c])
+                maze.setOpen(r, c, true);
+        }
+    }
+    // walk along each wall and place a door in each stretch between crossings
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; wallRow[r] && c < cols; ) {
+            int end = c;
+            while (end < cols && !wallCol[end])
+                end++;
+            maze.setOpen(r, c + rng() % (end - c), true);
+            c = end + 1;
+        }
+    }
+    for (int c = 0; c < cols; c++) {
+        for (int r = 0; wallCol[c] && r < rows; ) {
+            int end = r;
+            while (end < rows && !wallRow[end])
+                end++;
+            maze.setOpen(r + rng() % (end - r), c, true);
+            r = end + 1;
+        }
+    }
+}
+
+void generateMaze(MazeGenerator generator, int numRows, int numCols, uint32_t seed, FlatMaze& maze) {
+    maze.resize(numRows, numCols);
+    if (numRows == 0 || numCols == 0)
+        return;
+    mt19937 rng(seed);
+    if (generator == GEN_OPEN_ROOMS) {
+        buildOpenRooms(maze, rng);
+        return;
+    }
+
+    CellLattice cells = {&maze, (numRows + 1) / 2, (numCols + 1) / 2};
+    switch (generator) {
+        case GEN_BACKTRACKER: carveBacktracker(cells, rng); break;
+        case GEN_KRUSKAL: carveKruskal(cells, rng); break;
+        case GEN_WILSON: carveWilson(cells, rng); break;
+        default: error("generateMaze: unknown generator");
+    }
+    // an even dimension leaves a last row or column with no cells in it;
+    // copying its neighbor keeps the exit open and connected
+    if (numRows % 2 == 0) {
+        for (int c = 0; c < numCols; c++) {
+            maze.setOpen(numRows - 1, c, maze.isOpen(numRows - 2, c));
+        }
+    }
+    if (numCols % 2 == 0) {
+        for (int r = 0; r < numRows; r++) {
+            maze.setOpen(r, numCols - 1, maze.isOpen(r, numCols - 2));
+        }
+    }
+}
+
+void generateMaze(MazeGenerator generator, int numRows, int numCols, uint32_t seed, Grid<bool>& maze) {
+    FlatMaze flat;
+    generateMaze(generator, numRows, numCols, seed, flat);
+    maze.resize(numRows, numCols);
+    for (int r = 0; r < numRows; r++) {
+        for (int c = 0; c < numCols; c++) {
+            maze[r][c] = flat.isOpen(r, c);
+        }
+    }
+}
+
+void writeMazeFile(const FlatMaze& maze, string filename) {
+    ofstream out(filename);
+    if (!out)
+        error("Cannot open file named " + filename);
+    string line(maze.numCols(), '@');
+    for (int r = 0; r < maze.numRows(); r++) {
+        for (int c = 0; c < maze.numCols(); c++) {
+            line[c] = maze.isOpen(r, c) ? '-' : '@';
+        }
+        out << line << '\n';
+    }
+    if (!out)
+        error("Error writing maze file " + filename);
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+static const Vector<MazeGenerator> ALL_GENERATORS = {GEN_BACKTRACKER, GEN_KRUSKAL, GEN_WILSON,
+                                                     GEN_OPEN_ROOMS};
+
+/* Test helper that counts the open cells of maze and how many of them
+ * can be reached from the entry. */
+static void countCells(Grid<bool>& maze, int& open, int& reachable) {
+    open = reachable = 0;
+    for (int r = 0; r < maze.numRows(); r++) {
+        for (int c = 0; c < maze.numCols(); c++) {
+            open += maze[r][c];
+        }
+    }
+    Grid<bool> seen(maze.numRows(), maze.numCols());
+    Queue<GridLocation> queue;
+    queue.enqueue({0, 0});
+    seen[0][0] = true;
+    while (!queue.isEmpty()) {
+        GridLocation cur = queue.dequeue();
+        reachable++;
+        for (GridLocation next : generateValidMoves(maze, cur)) {
+            if (!seen[next.row][next.col]) {
+                seen[next.row][next.col] = true;
+                queue.enqueue(next);
+            }
+        }
+    }
+}
+
+STUDENT_TEST("Perfect maze generators carve a spanning tree of the cells") {
+    for (MazeGenerator generator : {GEN_BACKTRACKER, GEN_KRUSKAL, GEN_WILSON}) {
+        for (int size : {1, 3, 5, 21, 41}) {
+            Grid<bool> maze;
+            generateMaze(generator, size, size + 10, 106, maze);
+            int cells = (size + 1) / 2 * ((size + 11) / 2);
+            int open, reachable;
+            countCells(maze, open, reachable);
+            // a tree on n cells has n - 1 passages, and all of it is connected
+            EXPECT_EQUAL(open, 2 * cells - 1);
+            EXPECT_EQUAL(reachable, open);
+        }
+    }
+}
+
+STUDENT_TEST("Every generator connects the entry and exit at any size") {
+    for (MazeGenerator generator : ALL_GENERATORS) {
+        for (int rows : {1, 2, 7, 30, 101}) {
+            for (int cols : {1, 4, 9, 64, 130}) {
+                Grid<bool> maze;
+                generateMaze(generator, rows, cols, rows * 1000 + cols, maze);
+                EXPECT_EQUAL(maze.numRows(), rows);
+                EXPECT_EQUAL(maze.numCols(), cols);
+                Vector<GridLocation> path = solveMazeFlatBFS(maze);
+                EXPECT(!path.isEmpty());
+                EXPECT_NO_ERROR(validatePath(maze, path));
+            }
+        }
+    }
+}
+
+STUDENT_TEST("Generators repeat for the same seed and differ across seeds") {
+    for (MazeGenerator generator : ALL_GENERATORS) {
+        Grid<bool> a, b, c;
+        generateMaze(generator, 51, 61, 7, a);
+        generateMaze(generator, 51, 61, 7, b);
+        generateMaze(generator, 51, 61, 8, c);
+        EXPECT_EQUAL(a, b);
+        EXPECT(a != c);
+    }
+}
+
+STUDENT_TEST("writeMazeFile output reads back with readMazeFile") {
+    FlatMaze flat;
+    generateMaze(GEN_KRUSKAL, 23, 38, 1, flat);
+    writeMazeFile(flat, "res/generated.maze");
+    Grid<bool> read, expected;
+    readMazeFile("res/generated.maze", read);
+    generateMaze(GEN_KRUSKAL, 23, 38, 1, expected);
+    EXPECT_EQUAL(read, expected);
+    deleteFile("res/generated.maze");
+}
+
+/* Test helper that generates one maze per generator at size n x n and
+ * prints a row per solver with its time, working memory, cells expanded
+ * and path length. */
+static void benchmarkSolvers(int n, Vector<MazeSolver> solvers) {
+    for (MazeGenerator generator : ALL_GENERATORS) {
+        FlatMaze maze;
+        auto start = chrono::steady_clock::now();
+        generateMaze(generator, n, n, n, maze);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "    " << n << "^2 " << generatorName(generator) << " generated in "
+             << fixed << setprecision(3) << seconds << " s" << endl;
+        for (MazeSolver solver : solvers) {
+            SolverStats stats;
+            Vector<GridLocation> path = solveMaze(maze, solver, stats);
+            EXPECT(!path.isEmpty());
+            cout << "        " << setw(18) << left << solverName(solver) << right
+                 << fixed << setprecision(3) << setw(8) << stats.seconds << " s "
+                 << setw(8) << stats.bytes / (1 << 20) << " MB"
+                 << "  expanded " << setw(10) << stats.nodesExpanded
+                 << "  path " << setw(9) << path.size() << endl;
+        }
+    }
+}
+
+STUDENT_TEST("Solver scaling on generated mazes") {
+    // the path-copying BFS and DFS in maze.cpp cannot hold the paths of a
+    // maze this size, so only the FlatMaze solvers are compared
+    Vector<MazeSolver> solvers = {SOLVER_FLAT_BFS, SOLVER_BIDIRECTIONAL_BFS, SOLVER_ASTAR,
+                                  SOLVER_BIT_PARALLEL_BFS};
+    benchmarkSolvers(1025, solvers);
+    benchmarkSolvers(2049, solvers);
+//    benchmarkSolvers(4097, solvers);
+//    benchmarkSolvers(8193, solvers);
+//    benchmarkSolvers(16385, solvers);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "flatmaze.h"
+#include "grid.h"
+
+/*
+ * Algorithms for generating mazes of any size. The first three carve a
+ * perfect maze (exactly one path between any two cells) on the cells at
+ * even row and column; open rooms makes a grid of rooms joined by doors,
+ * with many equally short paths.
+ */
+enum MazeGenerator {
+    GEN_BACKTRACKER,        // depth-first carving: long winding corridors
+    GEN_KRUSKAL,            // random walls removed with union-find: many short dead ends
+    GEN_WILSON,             // loop-erased random walks: uniformly random spanning tree
+    GEN_OPEN_ROOMS          // rooms separated by walls with a door in each wall
+};
+
+std::string generatorName(MazeGenerator generator);
+
+/*
+ * Fills maze with a numRows x numCols maze made by the given algorithm. The
+ * same seed always gives the same maze. Both the entry (top left) and the
+ * exit (bottom right) are open and connected. Perfect mazes need odd
+ * dimensions; for an even dimension the last row or column repeats the one
+ * before it.
+ */
+void generateMaze(MazeGenerator generator, int numRows, int numCols, uint32_t seed, FlatMaze& maze);
+void generateMaze(MazeGenerator generator, int numRows, int numCols, uint32_t seed, Grid<bool>& maze);
+
+/*
+ * Writes maze in the format read by readMazeFile, one row at a time, so the
+ * text of the whole maze is never held in memory.
+ */
+void writeMazeFile(const FlatMaze& maze, std::string filename);
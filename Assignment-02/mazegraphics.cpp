@@ -7,8 +7,10 @@
  */
 
 #include "gwindow.h"
+#include <chrono>
 #include <iomanip>  // for setw, setfill
 #include "error.h"
+#include "gcolor.h"
 #include "gthread.h"
 #include "map.h"
 #include "mazegraphics.h"
@@ -26,6 +28,26 @@ struct cellT {
 };
 static Grid<cellT> cells;
 
+static const int kMinWindowSize = 200, kMaxWindowSize = 800;
+static const int kDefaultCellSize = 10;
+static const int kMaxShapeCells = 10000;    // larger mazes are drawn as a raster in RENDER_AUTO
+static const int kFrameMillis = 33;         // shortest time between unpaused raster frames
+
+static MazeRenderMode renderMode = RENDER_AUTO;
+
+// raster state: the maze, the pixels of the bare maze, and the frame shown,
+// which is the bare maze with the dots of shownPath painted over it
+struct rasterT {
+    Grid<bool> open;
+    Grid<int> background, frame;
+    int cellSize;           // pixels per cell side, or 1 when downsampling
+    int cellsPerPixel;      // cells per pixel side, or 1 when not downsampling
+    Vector<GridLocation> shownPath;
+    bool framePending;
+    chrono::steady_clock::time_point lastFrame;
+};
+static rasterT raster;
+
 void initialize() {
     window = new GWindow(1, 1);
     colors[false] = "Dark Gray";
@@ -40,18 +62,21 @@ void initialize() {
     intializedOnce = true;
 }
 
-void changeDimensions(int numRows, int numCols) {
-    static const int kMinWindowSize = 200, kMaxWindowSize = 800;
-    static const int kDefaultCellSize = 10;
+int cellSizeFor(int numRows, int numCols) {
+    int cellSize = kDefaultCellSize;
+    if (kDefaultCellSize*min(numRows, numCols) < kMinWindowSize)
+        cellSize = min(kMinWindowSize/min(numRows, numCols), kMaxWindowSize/max(numRows, numCols));
+    return max(cellSize, 1);
+}
 
+void changeDimensions(int numRows, int numCols) {
     if (!intializedOnce) initialize();
     window->setVisible(false);
     window->clear();
+    raster.open.clear();
     cells.clear();
     cells.resize(numRows, numCols);
-    int cellSize = kDefaultCellSize;
-    if (kDefaultCellSize*min(numRows, numCols) < kMinWindowSize)
-        cellSize = min(kMinWindowSize/min(numRows, numCols), kMaxWindowSize/max(numRows, numCols));
+    int cellSize = cellSizeFor(numRows, numCols);
     int dotSize = int(cellSize * .6);
     int margin = (cellSize - dotSize)/2;
     window->setCanvasSize(numCols*cellSize, numRows*cellSize);
@@ -66,7 +91,137 @@ void changeDimensions(int numRows, int numCols) {
     }
 }
 
+void setMazeRenderMode(MazeRenderMode mode) {
+    renderMode = mode;
+}
+
+/*
+ * Shows the raster frame. The whole frame goes to the window in one call.
+ */
+void showFrame() {
+    window->setPixels(raster.frame);
+    GThread::runOnQtGuiThread([] { window->repaint(); });
+    raster.framePending = false;
+    raster.lastFrame = chrono::steady_clock::now();
+}
+
+/*
+ * Blends two colors, taking weight parts in total of the second one.
+ */
+int blendRgb(int rgb1, int rgb2, int weight, int total) {
+    int blended = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int c1 = (rgb1 >> shift) & 0xff, c2 = (rgb2 >> shift) & 0xff;
+        blended |= ((c1 * (total - weight) + c2 * weight) / total) << shift;
+    }
+    return blended;
+}
+
+/*
+ * Renders the maze into the background pixels, one block of pixels per
+ * cell, or one pixel per block of cells if the maze is too large for the
+ * window.
+ */
+void drawRasterMaze(const Grid<bool>& g) {
+    if (!intializedOnce) initialize();
+    int numRows = g.numRows(), numCols = g.numCols();
+    if (!cells.isEmpty() || raster.open.numRows() != numRows || raster.open.numCols() != numCols) {
+        window->setVisible(false);
+        window->clear();
+        cells.clear();
+    }
+    raster.open = g;
+    raster.cellsPerPixel = (max(numRows, numCols) + kMaxWindowSize - 1) / kMaxWindowSize;
+    raster.cellSize = raster.cellsPerPixel > 1 ? 1 : cellSizeFor(numRows, numCols);
+    int height = raster.cellsPerPixel > 1 ? (numRows + raster.cellsPerPixel - 1) / raster.cellsPerPixel
+                                          : numRows * raster.cellSize;
+    int width = raster.cellsPerPixel > 1 ? (numCols + raster.cellsPerPixel - 1) / raster.cellsPerPixel
+                                         : numCols * raster.cellSize;
+    window->setCanvasSize(width, height);
+
+    int openRgb = GColor::convertColorToRGB(colors[true]);
+    int wallRgb = GColor::convertColorToRGB(colors[false]);
+    raster.background.resize(height, width);
+    if (raster.cellsPerPixel == 1) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                raster.background[y][x] = g[y / raster.cellSize][x / raster.cellSize] ? openRgb : wallRgb;
+            }
+        }
+    } else {
+        // count the walls and cells under each pixel, then shade by the ratio
+        Grid<int> walls(height, width), total(height, width);
+        for (int r = 0; r < numRows; r++) {
+            for (int c = 0; c < numCols; c++) {
+                int y = r / raster.cellsPerPixel, x = c / raster.cellsPerPixel;
+                total[y][x]++;
+                if (!g[r][c]) walls[y][x]++;
+            }
+        }
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                raster.background[y][x] = blendRgb(openRgb, wallRgb, walls[y][x], total[y][x]);
+            }
+        }
+    }
+    raster.frame = raster.background;
+    raster.shownPath.clear();
+    window->setVisible(true);
+    showFrame();
+}
+
+/*
+ * Calls fn(x, y) for each pixel of the dot marking loc.
+ */
+template <typename Fn>
+void forEachDotPixel(GridLocation loc, Fn fn) {
+    if (raster.cellsPerPixel > 1) {
+        fn(loc.col / raster.cellsPerPixel, loc.row / raster.cellsPerPixel);
+        return;
+    }
+    // dots of small cells would vanish, so they fill the whole cell
+    int dotSize = raster.cellSize >= 4 ? int(raster.cellSize * .6) : raster.cellSize;
+    int margin = (raster.cellSize - dotSize)/2;
+    for (int y = 0; y < dotSize; y++) {
+        for (int x = 0; x < dotSize; x++) {
+            fn(loc.col * raster.cellSize + margin + x, loc.row * raster.cellSize + margin + y);
+        }
+    }
+}
+
+/*
+ * Moves the dots in the frame from the path shown before to the new path.
+ * Only pixels under dots are touched, so the cost is proportional to the
+ * path lengths rather than the size of the maze.
+ */
+void highlightRasterPath(const Vector<GridLocation>& path, string color, int msecsToPause) {
+    for (GridLocation loc : raster.shownPath) {
+        forEachDotPixel(loc, [](int x, int y) { raster.frame[y][x] = raster.background[y][x]; });
+    }
+    int dotRgb = GColor::convertColorToRGB(color);
+    for (GridLocation loc : path) {
+        forEachDotPixel(loc, [dotRgb](int x, int y) { raster.frame[y][x] = dotRgb; });
+    }
+    raster.shownPath = path;
+    raster.framePending = true;
+
+    auto sinceLastFrame = chrono::steady_clock::now() - raster.lastFrame;
+    if (msecsToPause > 0 || sinceLastFrame >= chrono::milliseconds(kFrameMillis))
+        showFrame();
+    pause(msecsToPause);
+}
+
+void flushMazeGraphics() {
+    if (!raster.open.isEmpty() && raster.framePending)
+        showFrame();
+}
+
 void drawMaze(const Grid<bool>& g) {
+    if (renderMode == RENDER_RASTER || (renderMode == RENDER_AUTO && g.numRows() * g.numCols() > kMaxShapeCells)) {
+        drawRasterMaze(g);
+        pause(500); // wait a half-sec here
+        return;
+    }
     if (g.numRows() != cells.numRows() || g.numCols() != cells.numCols()) {
         changeDimensions(g.numRows(), g.numCols());
     }
@@ -87,11 +242,18 @@ void drawMaze(const Grid<bool>& g) {
 }
 
 void highlightPath(Vector<GridLocation>& path, string color, int msecsToPause) {
-    if (cells.isEmpty()) error("highlightPath called without previous call to drawMaze");
+    if (cells.isEmpty() && raster.open.isEmpty()) error("highlightPath called without previous call to drawMaze");
+
+    for (GridLocation loc: path) {
+        if (cells.isEmpty() ? !raster.open.inBounds(loc) : !cells.inBounds(loc)) error("highlightPath asked to highlight path location: " + loc.toString() + " that is out of bounds for drawn grid.");
+    }
+    if (cells.isEmpty()) {
+        highlightRasterPath(path, color, msecsToPause);
+        return;
+    }
 
     for (auto& c : cells) c.marked = false;
     for (GridLocation loc: path) {
-        if (!cells.inBounds(loc)) error("highlightPath asked to highlight path location: " + loc.toString() + " that is out of bounds for drawn grid.");
         cells[loc].marked = true;
     }
     for (auto& c : cells) {
@@ -108,7 +270,20 @@ void highlightPath(Vector<GridLocation>& path, string color, int msecsToPause) {
 }
 
 void printMaze() {
-    if (cells.isEmpty()) error("printMaze called without previous call to drawMaze");
+    if (cells.isEmpty() && raster.open.isEmpty()) error("printMaze called without previous call to drawMaze");
+
+    if (cells.isEmpty()) {
+        flushMazeGraphics();
+        Grid<bool> marked(raster.open.numRows(), raster.open.numCols());
+        for (GridLocation loc : raster.shownPath) marked[loc] = true;
+        for (const auto& loc : raster.open.locations()) {
+            char ch = raster.open[loc] ? ' ' : '@';
+            if (marked[loc]) ch = '+';
+            cout << setw(3) << setfill(' ') << ch;
+            if (loc.col == raster.open.numCols()-1) cout << endl;
+        }
+        return;
+    }
 
     for (const auto& loc : cells.locations()) {
         char ch = (cells[loc].square->isVisible()) ? '@' : ' ';
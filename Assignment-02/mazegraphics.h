@@ -51,3 +51,29 @@ void highlightPath(Vector<GridLocation>& p, std::string color, int msecsToPause
  */
 void printMaze();
 
+
+/**
+ * Mazes can be drawn two ways. Shape mode adds a square and a dot object
+ * to the window for every cell, which looks crisp but gets slow beyond a
+ * few thousand cells. Raster mode draws the maze into one pixel buffer and
+ * paints path dots into the same buffer, so each highlightPath call costs
+ * one buffer upload no matter how large the maze. Mazes too large for the
+ * window are downsampled: a pixel covering several cells is shaded by the
+ * fraction of walls among them, and is marked if any of them is on the path.
+ *
+ * The default, RENDER_AUTO, uses shapes for small mazes and raster for
+ * large ones. The mode takes effect at the next call to drawMaze.
+ */
+enum MazeRenderMode { RENDER_AUTO, RENDER_SHAPES, RENDER_RASTER };
+void setMazeRenderMode(MazeRenderMode mode);
+
+
+/**
+ * In raster mode, highlightPath calls with no pause that come faster than
+ * the frame rate only update the pixel buffer, so a solver can highlight
+ * after every step without waiting on the window. The flushMazeGraphics
+ * function shows the most recent path if its frame was skipped. Calls to
+ * highlightPath that pause, drawMaze and printMaze always show it.
+ */
+void flushMazeGraphics();
+
@@ -0,0 +1,768 @@
+/*
+ * Shortest-path oracle for answering many point-to-point queries on one
+ * maze: corridor compression, then LCA lookups on mazes without loops and
+ * A* with landmark lower bounds on mazes with them.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include "error.h"
+#include "mazegen.h"
+#include "mazeoracle.h"
+#include "random.h"
+#include "SimpleTest.h"
+using namespace std;
+
+static const uint32_t INFINITE = NO_CELL;
+
+MazeOracle::MazeOracle(const FlatMaze& maze, int numLandmarks) : _maze(maze) {
+    if (numLandmarks < 0)
+        error("MazeOracle: number of landmarks cannot be negative");
+    uint32_t n = _maze.numIndices();
+    _nodeAt.assign(n, NO_CELL);
+    _corridorAt.assign(n, NO_CELL);
+    _stepsIn.assign(n, 0);
+
+    // every open cell that does not have exactly two open neighbors is a node
+    for (int r = 0; r < _maze.numRows(); r++) {
+        for (int c = 0; c < _maze.numCols(); c++) {
+            uint32_t cell = _maze.index(r, c);
+            int mask = _maze.neighborMask(cell);
+            int degree = (mask & 1) + (mask >> 1 & 1) + (mask >> 2 & 1) + (mask >> 3 & 1);
+            if (_maze.isOpen(cell) && degree != 2)
+                addNode(cell);
+        }
+    }
+    for (uint32_t node = 0; node < _nodeCell.size(); node++) {
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            if (_maze.neighborMask(_nodeCell[node]) & bit)
+                walkCorridor(node, bit);
+        }
+    }
+    // open cells still unclaimed lie on loops with no junction at all;
+    // one cell of each loop becomes a node so the loop is an edge
+    for (int r = 0; r < _maze.numRows(); r++) {
+        for (int c = 0; c < _maze.numCols(); c++) {
+            uint32_t cell = _maze.index(r, c);
+            if (_maze.isOpen(cell) && _nodeAt[cell] == NO_CELL && _corridorAt[cell] == NO_CELL) {
+                addNode(cell);
+                uint32_t node = _nodeCell.size() - 1;
+                for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+                    if (_maze.neighborMask(cell) & bit)
+                        walkCorridor(node, bit);
+                }
+            }
+        }
+    }
+
+    buildArcs();
+    buildTree();
+    // landmarks are only needed for the A* search
+    _numLandmarks = _hasLoops ? min(numLandmarks, numNodes()) : 0;
+    chooseLandmarks();
+    _g.assign(_nodeCell.size(), 0);
+    _parentNode.assign(_nodeCell.size(), 0);
+    _parentArc.assign(_nodeCell.size(), 0);
+    _stamp.assign(_nodeCell.size(), 0);
+    _query = 0;
+    _settled = 0;
+}
+
+int MazeOracle::numNodes() const {
+    return _nodeCell.size();
+}
+
+int MazeOracle::numCorridors() const {
+    return _corridors.size();
+}
+
+bool MazeOracle::hasLoops() const {
+    return _hasLoops;
+}
+
+long MazeOracle::lastSettled() const {
+    return _settled;
+}
+
+void MazeOracle::addNode(uint32_t cell) {
+    _nodeAt[cell] = _nodeCell.size();
+    _nodeCell.push_back(cell);
+}
+
+/*
+ * Follows the corridor leaving node in direction bit until it reaches a
+ * node, recording the corridor unless it was already found from its
+ * other end.
+ */
+void MazeOracle::walkCorridor(uint32_t node, int bit) {
+    uint32_t prev = _nodeCell[node];
+    uint32_t cur = prev + _maze.moveOffset(bit);
+    if (_nodeAt[cur] != NO_CELL) {
+        // two adjacent nodes: an edge with no cells, added from the lower id
+        if (node < _nodeAt[cur])
+            _corridors.push_back({node, _nodeAt[cur], uint32_t(_corridorCells.size()), 0});
+        return;
+    }
+    if (_corridorAt[cur] != NO_CELL)
+        return;
+
+    uint32_t id = _corridors.size();
+    Corridor corridor = {node, NO_CELL, uint32_t(_corridorCells.size()), 0};
+    while (_nodeAt[cur] == NO_CELL) {
+        corridor.numCells++;
+        _corridorAt[cur] = id;
+        _stepsIn[cur] = corridor.numCells;
+        _corridorCells.push_back(cur);
+        // a corridor cell has two open neighbors: go to the one we did not come from
+        int mask = _maze.neighborMask(cur);
+        uint32_t next = prev;
+        for (int b = MOVE_UP; b <= MOVE_DOWN; b <<= 1) {
+            uint32_t neighbor = cur + _maze.moveOffset(b);
+            if ((mask & b) && neighbor != prev) {
+                next = neighbor;
+                break;
+            }
+        }
+        prev = cur;
+        cur = next;
+    }
+    corridor.to = _nodeAt[cur];
+    _corridors.push_back(corridor);
+}
+
+/*
+ * Lays out the arcs of each node contiguously (compressed sparse rows),
+ * one arc in each direction per corridor.
+ */
+void MazeOracle::buildArcs() {
+    _firstArc.assign(_nodeCell.size() + 1, 0);
+    for (const Corridor& corridor : _corridors) {
+        _firstArc[corridor.from + 1]++;
+        _firstArc[corridor.to + 1]++;
+    }
+    for (uint32_t v = 0; v < _nodeCell.size(); v++) {
+        _firstArc[v + 1] += _firstArc[v];
+    }
+    vector<uint32_t> fill(_firstArc.begin(), _firstArc.end() - 1);
+    _arcs.resize(2 * _corridors.size());
+    for (uint32_t id = 0; id < _corridors.size(); id++) {
+        const Corridor& corridor = _corridors[id];
+        uint32_t weight = corridor.numCells + 1;
+        _arcs[fill[corridor.from]++] = {corridor.to, weight, id};
+        _arcs[fill[corridor.to]++] = {corridor.from, weight, id};
+    }
+}
+
+/*
+ * Roots each component of the junction graph at its lowest node id and
+ * walks it depth first, giving each node a parent and its steps from the
+ * root. The graph has no loops exactly when it has numNodes - components
+ * corridors. Then the sparse table over the preorder is filled in, and
+ * otherwise the tree arrays are dropped, since A* answers the queries.
+ */
+void MazeOracle::buildTree() {
+    uint32_t n = _nodeCell.size();
+    _treeParent.assign(n, NO_CELL);
+    _treeCorridor.assign(n, NO_CELL);
+    _rootSteps.assign(n, 0);
+    _level.assign(n, 0);
+    _root.assign(n, NO_CELL);
+    _preorder.assign(n, 0);
+    vector<uint32_t> order, stack;
+    order.reserve(n);
+    uint32_t components = 0;
+    for (uint32_t root = 0; root < n; root++) {
+        if (_root[root] != NO_CELL)
+            continue;
+        components++;
+        _root[root] = root;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            _preorder[v] = order.size();
+            order.push_back(v);
+            for (uint32_t a = _firstArc[v]; a < _firstArc[v + 1]; a++) {
+                uint32_t w = _arcs[a].to;
+                if (_root[w] != NO_CELL)
+                    continue;
+                _root[w] = root;
+                _treeParent[w] = v;
+                _treeCorridor[w] = _arcs[a].corridor;
+                _rootSteps[w] = _rootSteps[v] + _arcs[a].weight;
+                _level[w] = _level[v] + 1;
+                stack.push_back(w);
+            }
+        }
+    }
+
+    _hasLoops = _corridors.size() != n - components;
+    if (_hasLoops) {
+        for (vector<uint32_t>* tree : {&_treeParent, &_treeCorridor, &_rootSteps, &_level, &_root, &_preorder}) {
+            vector<uint32_t>().swap(*tree);
+        }
+        return;
+    }
+    int rows = 1;
+    while ((uint64_t(1) << rows) <= n) {
+        rows++;
+    }
+    _lcaTable.resize(size_t(rows) * n);
+    copy(order.begin(), order.end(), _lcaTable.begin());
+    for (int k = 1; k < rows; k++) {
+        const uint32_t* prev = &_lcaTable[size_t(k - 1) * n];
+        uint32_t* row = &_lcaTable[size_t(k) * n];
+        uint32_t half = uint32_t(1) << (k - 1);
+        for (uint32_t i = 0; i + 2 * half <= n; i++) {
+            row[i] = _level[prev[i]] <= _level[prev[i + half]] ? prev[i] : prev[i + half];
+        }
+    }
+}
+
+/*
+ * Index of the highest set bit of a nonzero word.
+ */
+static inline int highestBit(uint32_t x) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(x);
+#else
+    int i = 0;
+    while (x >>= 1) {
+        i++;
+    }
+    return i;
+#endif
+}
+
+/*
+ * Returns the lowest common ancestor of two nodes of the same tree. Say u
+ * comes first in the preorder. The nodes after u, up to and including v,
+ * all lie below the LCA, and they include the LCA's child on the way to v,
+ * so the shallowest of them is a child of the LCA. The sparse table finds
+ * it from two overlapping power-of-two ranges.
+ */
+uint32_t MazeOracle::lowestCommonAncestor(uint32_t u, uint32_t v) const {
+    if (u == v)
+        return u;
+    uint32_t first = min(_preorder[u], _preorder[v]) + 1;
+    uint32_t last = max(_preorder[u], _preorder[v]);
+    int k = highestBit(last - first + 1);
+    const uint32_t* row = &_lcaTable[size_t(k) * _nodeCell.size()];
+    uint32_t a = row[first], b = row[last + 1 - (uint32_t(1) << k)];
+    return _treeParent[_level[a] <= _level[b] ? a : b];
+}
+
+uint32_t MazeOracle::treeSteps(uint32_t u, uint32_t v) const {
+    return _rootSteps[u] + _rootSteps[v] - 2 * _rootSteps[lowestCommonAncestor(u, v)];
+}
+
+/*
+ * Returns the distance from source to every node, by Dijkstra's algorithm
+ * on the junction graph.
+ */
+vector<uint32_t> MazeOracle::nodeDistances(uint32_t source) const {
+    vector<uint32_t> dist(_nodeCell.size(), INFINITE);
+    typedef pair<uint32_t, uint32_t> Entry;    // distance, node
+    priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+    dist[source] = 0;
+    queue.push({0, source});
+    while (!queue.empty()) {
+        Entry top = queue.top();
+        queue.pop();
+        if (top.first != dist[top.second])
+            continue;
+        for (uint32_t a = _firstArc[top.second]; a < _firstArc[top.second + 1]; a++) {
+            uint32_t d = top.first + _arcs[a].weight;
+            if (d < dist[_arcs[a].to]) {
+                dist[_arcs[a].to] = d;
+                queue.push({d, _arcs[a].to});
+            }
+        }
+    }
+    return dist;
+}
+
+/*
+ * Picks landmarks greedily, each one the node farthest from all landmarks
+ * picked so far, which spreads them around the edge of the maze where they
+ * give the tightest bounds.
+ */
+void MazeOracle::chooseLandmarks() {
+    int k = _numLandmarks;
+    _landmarkDist.assign(_nodeCell.size() * k, INFINITE);
+    if (k == 0)
+        return;
+    vector<uint32_t> nearest = nodeDistances(0);
+    for (int i = 0; i < k; i++) {
+        uint32_t pick = 0;
+        for (uint32_t v = 0; v < nearest.size(); v++) {
+            if (nearest[v] != INFINITE && (nearest[pick] == INFINITE || nearest[v] > nearest[pick]))
+                pick = v;
+        }
+        vector<uint32_t> dist = nodeDistances(pick);
+        for (uint32_t v = 0; v < dist.size(); v++) {
+            _landmarkDist[size_t(v) * k + i] = dist[v];
+            nearest[v] = min(nearest[v], dist[v]);
+        }
+    }
+}
+
+uint32_t MazeOracle::cellIndex(GridLocation loc) const {
+    if (loc.row < 0 || loc.row >= _maze.numRows() || loc.col < 0 || loc.col >= _maze.numCols())
+        error("MazeOracle: location is outside the maze");
+    uint32_t cell = _maze.index(loc.row, loc.col);
+    if (!_maze.isOpen(cell))
+        error("MazeOracle: location is a wall");
+    return cell;
+}
+
+MazeOracle::Attachment MazeOracle::attach(uint32_t cell) const {
+    if (_nodeAt[cell] != NO_CELL)
+        return {1, {_nodeAt[cell], 0}, {0, 0}};
+    const Corridor& corridor = _corridors[_corridorAt[cell]];
+    return {2, {corridor.from, corridor.to}, {_stepsIn[cell], corridor.numCells + 1 - _stepsIn[cell]}};
+}
+
+/*
+ * Returns the steps between two cells of the same corridor along it, or
+ * INFINITE if they are not in the same corridor.
+ */
+uint32_t MazeOracle::corridorSteps(uint32_t source, uint32_t target) const {
+    if (_corridorAt[source] == NO_CELL || _corridorAt[source] != _corridorAt[target])
+        return INFINITE;
+    return _stepsIn[source] > _stepsIn[target] ? _stepsIn[source] - _stepsIn[target]
+                                               : _stepsIn[target] - _stepsIn[source];
+}
+
+/*
+ * Query on a maze without loops: the best of the path along a corridor
+ * shared by source and target and the tree paths between each of the
+ * source's nodes and each of the target's. firstNode and lastNode are the
+ * nodes of the best tree path, or NO_CELL if the best path stays inside
+ * the shared corridor.
+ */
+uint32_t MazeOracle::treeSearch(uint32_t source, uint32_t target, uint32_t& firstNode, uint32_t& lastNode) const {
+    firstNode = lastNode = NO_CELL;
+    if (source == target)
+        return 0;
+    Attachment from = attach(source), to = attach(target);
+    if (_root[from.node[0]] != _root[to.node[0]])
+        return INFINITE;
+    uint32_t best = corridorSteps(source, target);
+    for (int e = 0; e < from.count; e++) {
+        for (int f = 0; f < to.count; f++) {
+            uint32_t steps = from.steps[e] + treeSteps(from.node[e], to.node[f]) + to.steps[f];
+            if (steps < best) {
+                best = steps;
+                firstNode = from.node[e];
+                lastNode = to.node[f];
+            }
+        }
+    }
+    return best;
+}
+
+/*
+ * Returns a lower bound on the steps from node to the target, or INFINITE
+ * if the landmarks show the two are not connected. By the triangle
+ * inequality, d(v, x) >= |d(L, x) - d(L, v)| for every landmark L.
+ */
+uint32_t MazeOracle::lowerBound(uint32_t node, const Attachment& target) const {
+    const uint32_t* fromNode = &_landmarkDist[size_t(node) * _numLandmarks];
+    uint32_t best = INFINITE;
+    for (int e = 0; e < target.count; e++) {
+        const uint32_t* fromTarget = &_landmarkDist[size_t(target.node[e]) * _numLandmarks];
+        uint32_t bound = 0;
+        bool connected = true;
+        for (int i = 0; i < _numLandmarks; i++) {
+            if ((fromNode[i] == INFINITE) != (fromTarget[i] == INFINITE)) {
+                connected = false;
+                break;
+            }
+            if (fromNode[i] != INFINITE) {
+                uint32_t diff = fromNode[i] > fromTarget[i] ? fromNode[i] - fromTarget[i]
+                                                            : fromTarget[i] - fromNode[i];
+                bound = max(bound, diff);
+            }
+        }
+        if (connected)
+            best = min(best, bound + target.steps[e]);
+    }
+    return best;
+}
+
+/*
+ * A* from the source cell's nodes until no open node can beat the best
+ * distance to the target found so far. Returns that distance, or INFINITE.
+ * lastNode and lastEnd say through which node and attachment the search
+ * reached the target; lastNode is NO_CELL if the best path stays inside
+ * the corridor shared by source and target.
+ */
+uint32_t MazeOracle::search(uint32_t source, uint32_t target, uint32_t& lastNode, int& lastEnd) {
+    _settled = 0;
+    lastNode = NO_CELL;
+    lastEnd = 0;
+    if (source == target)
+        return 0;
+    Attachment from = attach(source), to = attach(target);
+    uint32_t best = corridorSteps(source, target);
+
+    if (++_query == 0) {
+        fill(_stamp.begin(), _stamp.end(), 0);
+        _query = 1;
+    }
+    auto later = [](const OpenNode& a, const OpenNode& b) {
+        return a.f > b.f || (a.f == b.f && a.g < b.g);
+    };
+    _open.clear();
+    for (int e = 0; e < from.count; e++) {
+        uint32_t v = from.node[e], g = from.steps[e];
+        if (_stamp[v] == _query && _g[v] <= g)
+            continue;
+        _stamp[v] = _query;
+        _g[v] = g;
+        _parentNode[v] = NO_CELL;
+        _parentArc[v] = e;
+        uint32_t h = lowerBound(v, to);
+        if (h != INFINITE) {
+            _open.push_back({g + h, g, v});
+            push_heap(_open.begin(), _open.end(), later);
+        }
+    }
+
+    while (!_open.empty()) {
+        pop_heap(_open.begin(), _open.end(), later);
+        OpenNode cur = _open.back();
+        _open.pop_back();
+        if (cur.g != _g[cur.node])
+            continue;
+        if (cur.f >= best)
+            break;
+        _settled++;
+        for (int e = 0; e < to.count; e++) {
+            if (to.node[e] == cur.node && cur.g + to.steps[e] < best) {
+                best = cur.g + to.steps[e];
+                lastNode = cur.node;
+                lastEnd = e;
+            }
+        }
+        for (uint32_t a = _firstArc[cur.node]; a < _firstArc[cur.node + 1]; a++) {
+            uint32_t w = _arcs[a].to, g = cur.g + _arcs[a].weight;
+            if (_stamp[w] == _query && _g[w] <= g)
+                continue;
+            _stamp[w] = _query;
+            _g[w] = g;
+            _parentNode[w] = cur.node;
+            _parentArc[w] = a;
+            uint32_t h = lowerBound(w, to);
+            if (h != INFINITE && g + h < best) {
+                _open.push_back({g + h, g, w});
+                push_heap(_open.begin(), _open.end(), later);
+            }
+        }
+    }
+    return best;
+}
+
+int MazeOracle::distance(GridLocation source, GridLocation target) {
+    uint32_t firstNode, lastNode;
+    int lastEnd;
+    uint32_t best;
+    if (_hasLoops) {
+        best = search(cellIndex(source), cellIndex(target), lastNode, lastEnd);
+    } else {
+        _settled = 0;
+        best = treeSearch(cellIndex(source), cellIndex(target), firstNode, lastNode);
+    }
+    return best == INFINITE ? -1 : int(best);
+}
+
+/*
+ * Appends the cells of a corridor from step fromStep to step toStep, both
+ * included, where step 0 is the corridor's from node and step
+ * numCells + 1 its to node.
+ */
+void MazeOracle::appendCorridor(Vector<GridLocation>& path, uint32_t corridor,
+                                uint32_t fromStep, uint32_t toStep) const {
+    const Corridor& c = _corridors[corridor];
+    int dir = toStep >= fromStep ? 1 : -1;
+    for (uint32_t step = fromStep; ; step += dir) {
+        uint32_t cell = step == 0 ? _nodeCell[c.from]
+                      : step == c.numCells + 1 ? _nodeCell[c.to]
+                      : _corridorCells[c.firstCell + step - 1];
+        path.add(_maze.location(cell));
+        if (step == toStep)
+            break;
+    }
+}
+
+Vector<GridLocation> MazeOracle::shortestPath(GridLocation sourceLoc, GridLocation targetLoc) {
+    uint32_t source = cellIndex(sourceLoc), target = cellIndex(targetLoc);
+    // the nodes of the path in order, corridors[i] joining nodes[i] and
+    // nodes[i + 1], and which attachment of source and target it goes through
+    vector<uint32_t> nodes, corridors;
+    int firstEnd = 0, lastEnd = 0;
+    uint32_t best, firstNode, lastNode;
+    if (_hasLoops) {
+        best = search(source, target, lastNode, lastEnd);
+        for (uint32_t v = lastNode; v != NO_CELL; v = _parentNode[v]) {
+            nodes.push_back(v);
+            if (_parentNode[v] != NO_CELL)
+                corridors.push_back(_arcs[_parentArc[v]].corridor);
+        }
+        reverse(nodes.begin(), nodes.end());
+        reverse(corridors.begin(), corridors.end());
+        if (!nodes.empty())
+            firstEnd = _parentArc[nodes[0]];
+    } else {
+        _settled = 0;
+        best = treeSearch(source, target, firstNode, lastNode);
+        if (firstNode != NO_CELL) {
+            // up from firstNode to the LCA, then down to lastNode
+            uint32_t top = lowestCommonAncestor(firstNode, lastNode);
+            for (uint32_t v = firstNode; v != top; v = _treeParent[v]) {
+                nodes.push_back(v);
+                corridors.push_back(_treeCorridor[v]);
+            }
+            nodes.push_back(top);
+            size_t down = nodes.size();
+            for (uint32_t v = lastNode; v != top; v = _treeParent[v]) {
+                nodes.push_back(v);
+                corridors.push_back(_treeCorridor[v]);
+            }
+            reverse(nodes.begin() + down, nodes.end());
+            reverse(corridors.begin() + (down - 1), corridors.end());
+            firstEnd = attach(source).node[0] == firstNode ? 0 : 1;
+            lastEnd = attach(target).node[0] == lastNode ? 0 : 1;
+        }
+    }
+
+    Vector<GridLocation> path;
+    if (best == INFINITE)
+        return path;
+    if (source == target) {
+        path.add(sourceLoc);
+        return path;
+    }
+    if (nodes.empty()) {
+        appendCorridor(path, _corridorAt[source], _stepsIn[source], _stepsIn[target]);
+        return path;
+    }
+
+    if (_nodeAt[source] != NO_CELL) {
+        path.add(sourceLoc);
+    } else {
+        const Corridor& c = _corridors[_corridorAt[source]];
+        appendCorridor(path, _corridorAt[source], _stepsIn[source], firstEnd == 0 ? 0 : c.numCells + 1);
+    }
+    for (size_t i = 0; i < corridors.size(); i++) {
+        const Corridor& c = _corridors[corridors[i]];
+        if (c.from == nodes[i])
+            appendCorridor(path, corridors[i], 1, c.numCells + 1);
+        else
+            appendCorridor(path, corridors[i], c.numCells, 0);
+    }
+    if (_nodeAt[target] == NO_CELL) {
+        const Corridor& c = _corridors[_corridorAt[target]];
+        if (lastEnd == 0)
+            appendCorridor(path, _corridorAt[target], 1, _stepsIn[target]);
+        else
+            appendCorridor(path, _corridorAt[target], c.numCells, _stepsIn[target]);
+    }
+    return path;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper that finds the BFS distance from source to every cell. */
+static vector<uint32_t> bfsFrom(const FlatMaze& maze, uint32_t source) {
+    vector<uint32_t> dist(maze.numIndices(), NO_CELL);
+    vector<uint32_t> queue = {source};
+    dist[source] = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t cur = queue[head];
+        int mask = maze.neighborMask(cur);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            uint32_t next = cur + maze.moveOffset(bit);
+            if ((mask & bit) && dist[next] == NO_CELL) {
+                dist[next] = dist[cur] + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+    return dist;
+}
+
+/* Test helper that checks a path of open, adjacent cells from source to
+ * target with the given number of steps. */
+static bool isPathBetween(const FlatMaze& maze, const Vector<GridLocation>& path,
+                          GridLocation source, GridLocation target, int steps) {
+    if (path.size() != steps + 1 || !(path[0] == source) || !(path[path.size() - 1] == target))
+        return false;
+    for (int i = 0; i < path.size(); i++) {
+        if (!maze.isOpen(path[i].row, path[i].col))
+            return false;
+        if (i > 0 && moveBetween(path[i - 1], path[i]) == 0)
+            return false;
+    }
+    return true;
+}
+
+/* Test helper that compares every query from a sample of sources against
+ * a BFS of the whole maze. */
+static void checkAgainstBFS(const FlatMaze& maze, int numSources) {
+    MazeOracle oracle(maze);
+    Vector<GridLocation> open;
+    for (int r = 0; r < maze.numRows(); r++) {
+        for (int c = 0; c < maze.numCols(); c++) {
+            if (maze.isOpen(r, c))
+                open.add({r, c});
+        }
+    }
+    for (int i = 0; i < numSources; i++) {
+        GridLocation source = open[randomInteger(0, open.size() - 1)];
+        vector<uint32_t> dist = bfsFrom(maze, maze.index(source.row, source.col));
+        for (GridLocation target : open) {
+            uint32_t expected = dist[maze.index(target.row, target.col)];
+            int steps = oracle.distance(source, target);
+            EXPECT_EQUAL(steps, expected == NO_CELL ? -1 : int(expected));
+            if (steps >= 0 && target.row % 3 == 0)
+                EXPECT(isPathBetween(maze, oracle.shortestPath(source, target), source, target, steps));
+        }
+    }
+}
+
+STUDENT_TEST("MazeOracle compresses corridors into junctions") {
+    // a loop with one branch, plus a separate ring with no junction at all
+    Grid<bool> grid = {{true,  true,  true,  false, true,  true},
+                       {true,  false, true,  false, true,  true},
+                       {true,  true,  true,  true,  false, false},
+                       {false, false, false, true,  false, false}};
+    FlatMaze maze(grid);
+    MazeOracle oracle(maze);
+    // junction (2,2), dead end (3,3) and one node for the ring; the left
+    // loop is a corridor from the junction back to itself
+    EXPECT_EQUAL(oracle.numNodes(), 3);
+    EXPECT_EQUAL(oracle.numCorridors(), 3);
+    EXPECT(oracle.hasLoops());
+    EXPECT_EQUAL(oracle.distance({0, 0}, {3, 3}), 6);
+    EXPECT_EQUAL(oracle.distance({0, 1}, {1, 0}), 2);
+    EXPECT_EQUAL(oracle.distance({0, 4}, {1, 5}), 2);
+    EXPECT_EQUAL(oracle.distance({0, 0}, {0, 4}), -1);
+    EXPECT(oracle.shortestPath({0, 0}, {0, 4}).isEmpty());
+    EXPECT_EQUAL(oracle.shortestPath({1, 0}, {1, 0}), {{1, 0}});
+    EXPECT_EQUAL(oracle.shortestPath({0, 1}, {2, 3}), {{0, 1}, {0, 2}, {1, 2}, {2, 2}, {2, 3}});
+    EXPECT_ERROR(oracle.distance({0, 3}, {0, 0}));
+    EXPECT_ERROR(oracle.distance({0, 0}, {4, 0}));
+}
+
+STUDENT_TEST("MazeOracle answers mazes without loops from the tree") {
+    // two trees: a T of corridors on the left, and a single corridor
+    Grid<bool> grid = {{true,  true,  true,  true,  false, true},
+                       {false, true,  false, false, false, true},
+                       {false, true,  false, true,  true,  true},
+                       {true,  true,  false, false, false, false}};
+    FlatMaze maze(grid);
+    MazeOracle oracle(maze);
+    EXPECT(!oracle.hasLoops());
+    // junction (0,1); dead ends (0,0), (0,3), (3,0), (0,5) and (2,3)
+    EXPECT_EQUAL(oracle.numNodes(), 6);
+    EXPECT_EQUAL(oracle.numCorridors(), 4);
+    EXPECT_EQUAL(oracle.distance({0, 0}, {3, 0}), 5);
+    EXPECT_EQUAL(oracle.distance({0, 3}, {2, 1}), 4);
+    EXPECT_EQUAL(oracle.distance({1, 1}, {2, 1}), 1);
+    EXPECT_EQUAL(oracle.distance({1, 5}, {2, 4}), 2);
+    EXPECT_EQUAL(oracle.distance({0, 2}, {0, 2}), 0);
+    EXPECT_EQUAL(oracle.distance({0, 2}, {2, 4}), -1);
+    EXPECT_EQUAL(oracle.lastSettled(), 0);
+    EXPECT_EQUAL(oracle.shortestPath({0, 2}, {3, 0}), {{0, 2}, {0, 1}, {1, 1}, {2, 1}, {3, 1}, {3, 0}});
+    EXPECT_EQUAL(oracle.shortestPath({2, 1}, {1, 1}), {{2, 1}, {1, 1}});
+    EXPECT_EQUAL(oracle.shortestPath({0, 5}, {2, 3}), {{0, 5}, {1, 5}, {2, 5}, {2, 4}, {2, 3}});
+    EXPECT(oracle.shortestPath({0, 0}, {0, 5}).isEmpty());
+}
+
+STUDENT_TEST("MazeOracle distances match BFS on generated mazes") {
+    setRandomSeed(36);
+    for (MazeGenerator generator : {GEN_BACKTRACKER, GEN_KRUSKAL, GEN_WILSON, GEN_OPEN_ROOMS}) {
+        FlatMaze maze;
+        generateMaze(generator, 41, 53, 36, maze);
+        checkAgainstBFS(maze, 10);
+    }
+    // walling off cells of a perfect maze leaves a forest of several trees
+    FlatMaze forest;
+    generateMaze(GEN_WILSON, 41, 53, 38, forest);
+    for (int i = 0; i < 40; i++) {
+        forest.setOpen(randomInteger(0, 40), randomInteger(0, 52), false);
+    }
+    EXPECT(!MazeOracle(forest).hasLoops());
+    checkAgainstBFS(forest, 10);
+    // braided mazes have many loops, and random grids many components
+    FlatMaze braided;
+    generateMaze(GEN_KRUSKAL, 41, 53, 37, braided);
+    for (int i = 0; i < 300; i++) {
+        braided.setOpen(randomInteger(0, 40), randomInteger(0, 52), true);
+    }
+    EXPECT(MazeOracle(braided).hasLoops());
+    checkAgainstBFS(braided, 10);
+    Grid<bool> random(30, 30);
+    for (int r = 0; r < 30; r++) {
+        for (int c = 0; c < 30; c++) {
+            random[r][c] = randomChance(0.6);
+        }
+    }
+    checkAgainstBFS(FlatMaze(random), 10);
+}
+
+/* Test helper that times building an oracle for maze and answering
+ * random queries between cells on the maze's even rows and columns. */
+static void timeQueries(const FlatMaze& maze, string name) {
+    int n = maze.numRows();
+    unique_ptr<MazeOracle> oracle;
+    TIME_OPERATION(n * n, oracle.reset(new MazeOracle(maze)));
+    cout << "    " << name << ": " << oracle->numNodes() << " nodes, " << oracle->numCorridors()
+         << " corridors, " << (oracle->hasLoops() ? "A* with landmarks" : "tree lookups") << endl;
+
+    Vector<GridLocation> sources, targets;
+    for (int i = 0; i < 1000; i++) {
+        sources.add({randomInteger(0, n / 2) * 2, randomInteger(0, n / 2) * 2});
+        targets.add({randomInteger(0, n / 2) * 2, randomInteger(0, n / 2) * 2});
+    }
+    long settled = 0, steps = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < sources.size(); i++) {
+        steps += oracle->distance(sources[i], targets[i]);
+        settled += oracle->lastSettled();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "    " << sources.size() << " queries: " << seconds / sources.size() * 1e6
+         << " us per query, " << settled / sources.size() << " nodes settled and "
+         << steps / sources.size() << " steps per path on average" << endl;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < sources.size(); i++) {
+        steps += oracle->shortestPath(sources[i], targets[i]).size();
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "    " << sources.size() << " paths: " << seconds / sources.size() * 1e6 << " us per path" << endl;
+}
+
+STUDENT_TEST("Time MazeOracle queries on a large maze") {
+    setRandomSeed(360);
+    int n = 1025;
+    for (MazeGenerator generator : {GEN_KRUSKAL, GEN_BACKTRACKER}) {
+        FlatMaze maze;
+        generateMaze(generator, n, n, 36, maze);
+        timeQueries(maze, generatorName(generator));
+    }
+    // the same with loops, which falls back to A*
+    FlatMaze braided;
+    generateMaze(GEN_KRUSKAL, n, n, 36, braided);
+    for (int i = 0; i < n * n / 100; i++) {
+        braided.setOpen(randomInteger(0, n - 1), randomInteger(0, n - 1), true);
+    }
+    timeQueries(braided, "braided " + generatorName(GEN_KRUSKAL));
+}
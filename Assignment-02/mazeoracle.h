@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "flatmaze.h"
+#include "gridlocation.h"
+#include "vector.h"
+
+/**
+ * Answers shortest-path queries between any two open cells of a fixed
+ * maze, after preprocessing the maze once.
+ *
+ * Preprocessing compresses the maze into a junction graph. Every open cell
+ * with other than two open neighbors (junctions, dead ends and isolated
+ * cells) becomes a node. Each corridor of two-neighbor cells between two
+ * nodes becomes one weighted edge that remembers its cells. A query from
+ * or to the middle of a corridor starts or ends at both of its nodes.
+ *
+ * A perfect maze has no loops, so its junction graph is a tree, or a
+ * forest if walls cut it apart. Then the path between two nodes is the
+ * one through their lowest common ancestor (LCA), and the oracle stores
+ * each node's steps from the root and a sparse table that finds the LCA
+ * with two lookups. A distance is O(1), and a path is a walk up the tree
+ * from both ends.
+ *
+ * A maze with loops keeps the search: for a few landmark nodes picked far
+ * apart, the distance from the landmark to every node is stored, and a
+ * query runs A* on the junction graph with the largest
+ * |d(L, target) - d(L, v)| over the landmarks L as its estimate of the
+ * distance left (ALT: A*, landmarks, triangle inequality). Such queries
+ * still visit many nodes on large mazes, so they take milliseconds rather
+ * than microseconds.
+ *
+ * Compression pays off on corridor mazes such as perfect mazes. In open
+ * areas almost every cell is a junction. Queries reuse search arrays held
+ * by the oracle, so one oracle must not answer queries from several
+ * threads at once.
+ */
+class MazeOracle {
+public:
+    /**
+     * Preprocesses maze, which the oracle copies.
+     */
+    explicit MazeOracle(const FlatMaze& maze, int numLandmarks = DEFAULT_LANDMARKS);
+
+    int numNodes() const;
+    int numCorridors() const;
+
+    /**
+     * Returns whether the maze has a loop, so that queries search with A*
+     * rather than look up the tree.
+     */
+    bool hasLoops() const;
+
+    /**
+     * Returns the number of steps on a shortest path between two open
+     * cells, or -1 if target cannot be reached from source. Raises an
+     * error if either location is a wall or outside the maze.
+     */
+    int distance(GridLocation source, GridLocation target);
+
+    /**
+     * Returns a shortest path from source to target, both included, or an
+     * empty path if there is none.
+     */
+    Vector<GridLocation> shortestPath(GridLocation source, GridLocation target);
+
+    /**
+     * Number of nodes the last query took off its open list, which is 0
+     * for queries answered from the tree.
+     */
+    long lastSettled() const;
+
+    static const int DEFAULT_LANDMARKS = 8;
+
+private:
+    // a corridor between two nodes; cells lists the cells strictly between
+    // from and to, in order from from, so the edge is numCells + 1 steps long
+    struct Corridor {
+        uint32_t from, to;
+        uint32_t firstCell, numCells;
+    };
+    struct Arc {
+        uint32_t to, weight, corridor;
+    };
+    // where a query cell joins the graph: up to two nodes and the steps to each
+    struct Attachment {
+        int count;
+        uint32_t node[2], steps[2];
+    };
+    struct OpenNode {
+        uint32_t f, g, node;
+    };
+
+    FlatMaze _maze;
+    std::vector<uint32_t> _nodeAt;          // per cell index: node id, or NO_CELL
+    std::vector<uint32_t> _corridorAt;      // per cell index: corridor id, or NO_CELL
+    std::vector<uint32_t> _stepsIn;         // per cell index: steps from its corridor's from node
+    std::vector<uint32_t> _nodeCell;        // per node: its cell index
+    std::vector<Corridor> _corridors;
+    std::vector<uint32_t> _corridorCells;
+    std::vector<uint32_t> _firstArc;        // arcs of node v are [_firstArc[v], _firstArc[v + 1])
+    std::vector<Arc> _arcs;
+    bool _hasLoops;
+
+    // the tree of a maze without loops, rooted at the lowest node id of each
+    // component; _lcaTable row k holds, for each position i of the preorder,
+    // the shallowest node among positions [i, i + 2^k)
+    std::vector<uint32_t> _treeParent;      // per node: parent node, or NO_CELL for a root
+    std::vector<uint32_t> _treeCorridor;    // per node: corridor to its parent
+    std::vector<uint32_t> _rootSteps;       // per node: steps from its root
+    std::vector<uint32_t> _level;           // per node: corridors from its root
+    std::vector<uint32_t> _root;            // per node: the root of its component
+    std::vector<uint32_t> _preorder;        // per node: position in the preorder
+    std::vector<uint32_t> _lcaTable;        // row k starts at k * numNodes()
+
+    int _numLandmarks;
+    std::vector<uint32_t> _landmarkDist;    // node * _numLandmarks + landmark
+
+    // per-query state, valid for nodes whose stamp equals the query number;
+    // a node seeded from the source has no parent node, and its parent arc
+    // is the index of the source attachment used instead
+    std::vector<uint32_t> _g, _parentNode, _parentArc, _stamp;
+    std::vector<OpenNode> _open;
+    uint32_t _query;
+    long _settled;
+
+    void addNode(uint32_t cell);
+    void walkCorridor(uint32_t node, int bit);
+    void buildArcs();
+    void buildTree();
+    uint32_t lowestCommonAncestor(uint32_t u, uint32_t v) const;
+    uint32_t treeSteps(uint32_t u, uint32_t v) const;
+    uint32_t treeSearch(uint32_t source, uint32_t target, uint32_t& firstNode, uint32_t& lastNode) const;
+    void chooseLandmarks();
+    std::vector<uint32_t> nodeDistances(uint32_t source) const;
+    uint32_t cellIndex(GridLocation loc) const;
+    Attachment attach(uint32_t cell) const;
+    uint32_t corridorSteps(uint32_t source, uint32_t target) const;
+    uint32_t lowerBound(uint32_t node, const Attachment& target) const;
+    uint32_t search(uint32_t source, uint32_t target, uint32_t& lastNode, int& lastEnd);
+    void appendCorridor(Vector<GridLocation>& path, uint32_t corridor, uint32_t fromStep, uint32_t toStep) const;
+};
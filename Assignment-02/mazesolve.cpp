@@ -0,0 +1,588 @@
+/*
+ * Solver strategies for large mazes: bidirectional BFS and A*, plus a
+ * common entry point that runs any solver and reports its statistics.
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include "error.h"
+#include "maze.h"
+#include "mazesolve.h"
+#include "random.h"
+#include "SimpleTest.h"
+using namespace std;
+
+string solverName(MazeSolver solver) {
+    switch (solver) {
+        case SOLVER_BFS: return "BFS";
+        case SOLVER_DFS: return "DFS";
+        case SOLVER_FLAT_BFS: return "flat BFS";
+        case SOLVER_BIDIRECTIONAL_BFS: return "bidirectional BFS";
+        case SOLVER_ASTAR: return "A*";
+        case SOLVER_BIT_PARALLEL_BFS: return "bit-parallel BFS";
+    }
+    return "unknown";
+}
+
+Vector<GridLocation> solveMazeBidirectionalBFS(const FlatMaze& maze, long& expanded) {
+    expanded = 0;
+    if (maze.numRows() == 0 || maze.numCols() == 0)
+        return {};
+    uint32_t entry = maze.index(0, 0);
+    uint32_t exit = maze.index(maze.numRows() - 1, maze.numCols() - 1);
+    if (!maze.isOpen(entry) || !maze.isOpen(exit))
+        return {};
+    if (entry == exit)
+        return {maze.location(entry)};
+
+    // dist[0] counts steps from the entry, dist[1] from the exit
+    vector<uint32_t> dist[2] = {vector<uint32_t>(maze.numIndices(), NO_CELL),
+                                vector<uint32_t>(maze.numIndices(), NO_CELL)};
+    vector<uint32_t> frontier[2] = {{entry}, {exit}};
+    vector<uint32_t> next;
+    dist[0][entry] = 0;
+    dist[1][exit] = 0;
+    uint32_t meet = NO_CELL, best = NO_CELL;
+
+    while (meet == NO_CELL && !frontier[0].empty() && !frontier[1].empty()) {
+        int side = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+        vector<uint32_t>& mine = dist[side];
+        vector<uint32_t>& other = dist[1 - side];
+        next.clear();
+        // finish the whole level even after a meeting, keeping the best one
+        for (uint32_t cur : frontier[side]) {
+            expanded++;
+            int moves = maze.neighborMask(cur);
+            for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+                uint32_t nb = cur + maze.moveOffset(bit);
+                if (!(moves & bit) || mine[nb] != NO_CELL)
+                    continue;
+                mine[nb] = mine[cur] + 1;
+                next.push_back(nb);
+                if (other[nb] != NO_CELL && mine[nb] + other[nb] < best) {
+                    best = mine[nb] + other[nb];
+                    meet = nb;
+                }
+            }
+        }
+        frontier[side].swap(next);
+    }
+
+    if (meet == NO_CELL)
+        return {};
+    Vector<GridLocation> path = pathFromDistances(maze, dist[0], meet);
+    Vector<GridLocation> tail = pathFromDistances(maze, dist[1], meet); // exit -> meet
+    for (int i = tail.size() - 2; i >= 0; i--) {
+        path.add(tail[i]);
+    }
+    return path;
+}
+
+/*
+ * Entry in the A* open list. h is not stored: it is f - g.
+ */
+struct OpenCell {
+    uint32_t f, g, cell;
+};
+
+// Orders the heap so the top has the smallest f, then the largest g.
+struct OpenCellOrder {
+    bool operator()(const OpenCell& a, const OpenCell& b) const {
+        return a.f > b.f || (a.f == b.f && a.g < b.g);
+    }
+};
+
+Vector<GridLocation> solveMazeAStar(const FlatMaze& maze, long& expanded) {
+    expanded = 0;
+    if (maze.numRows() == 0 || maze.numCols() == 0)
+        return {};
+    uint32_t entry = maze.index(0, 0);
+    uint32_t exit = maze.index(maze.numRows() - 1, maze.numCols() - 1);
+    if (!maze.isOpen(entry) || !maze.isOpen(exit))
+        return {};
+
+    // Manhattan distance is consistent on a unit grid, so a cell's g is
+    // final when it is first expanded and stale heap entries are skipped
+    vector<uint32_t> g(maze.numIndices(), NO_CELL);
+    priority_queue<OpenCell, vector<OpenCell>, OpenCellOrder> open;
+    uint32_t h0 = maze.numRows() - 1 + maze.numCols() - 1;
+    g[entry] = 0;
+    open.push({h0, 0, entry});
+
+    while (!open.empty()) {
+        OpenCell cur = open.top();
+        open.pop();
+        if (cur.g != g[cur.cell])
+            continue;
+        expanded++;
+        if (cur.cell == exit)
+            return pathFromDistances(maze, g, exit);
+
+        uint32_t h = cur.f - cur.g;
+        int moves = maze.neighborMask(cur.cell);
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            uint32_t nb = cur.cell + maze.moveOffset(bit);
+            uint32_t ng = cur.g + 1;
+            if ((moves & bit) && ng < g[nb]) {
+                g[nb] = ng;
+                // right and down move toward the exit
+                uint32_t nh = (bit == MOVE_RIGHT || bit == MOVE_DOWN) ? h - 1 : h + 1;
+                open.push({ng + nh, ng, nb});
+            }
+        }
+    }
+    return {};
+}
+
+/*
+ * Cell bitmaps for the bit-parallel BFS, stored one anti-diagonal per
+ * padded row: cell (r, c) is bit r + 1 of diagonal r + c + 1. A search
+ * from a corner advances about one diagonal per level, so its frontier is
+ * packed into a few consecutive words instead of one bit in each row.
+ * Diagonals 0 and numDiagonals + 1, and bit 0 of every diagonal, are
+ * padding and stay clear.
+ */
+struct DiagonalBits {
+    int numDiagonals;
+    int wordsPerDiagonal;
+    vector<uint64_t> words;
+
+    DiagonalBits(int rows, int cols) {
+        numDiagonals = rows + cols - 1;
+        wordsPerDiagonal = (rows + 2 + 63) / 64;
+        words.assign(size_t(numDiagonals + 2) * wordsPerDiagonal, 0);
+    }
+
+    size_t wordOf(int r, int c) const {
+        return size_t(r + c + 1) * wordsPerDiagonal + ((r + 1) >> 6);
+    }
+
+    int bitOf(int r, int c) const {
+        return int(words[wordOf(r, c)] >> ((r + 1) & 63) & 1);
+    }
+};
+
+/*
+ * Transposes a 64x64 bit matrix in place, so that bit j of a[i] becomes
+ * bit i of a[j], by swapping ever smaller off-diagonal blocks.
+ */
+static void transpose64(uint64_t a[64]) {
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = (a[k] ^ (a[k | j] << j)) & ~mask;
+            a[k] ^= t;
+            a[k | j] ^= t >> j;
+        }
+    }
+}
+
+/*
+ * Returns bits [start, start + 64) of a row of numWords words, reading
+ * bits outside the row as zero.
+ */
+static uint64_t bitWindow(const uint64_t* row, int numWords, int start) {
+    int w = start >= 0 ? start / 64 : -((63 - start) / 64);
+    int shift = start - w * 64;
+    uint64_t low = w >= 0 && w < numWords ? row[w] : 0;
+    uint64_t high = w + 1 >= 0 && w + 1 < numWords ? row[w + 1] : 0;
+    return shift == 0 ? low : (low >> shift) | (high << (64 - shift));
+}
+
+/*
+ * Copies the open cells of maze into diagonal layout, 64 rows by 64
+ * diagonals at a time: row r contributes the 64 bits starting at column
+ * d - r, and a bit transpose turns those rows into diagonal words.
+ */
+static void skewOpenCells(const FlatMaze& maze, DiagonalBits& open) {
+    int rows = maze.numRows();
+    int D = open.numDiagonals, W = open.wordsPerDiagonal;
+    int mazeWords = maze.wordsPerRow();
+    const uint64_t* bits = maze.words();
+    uint64_t block[64];
+    for (int w = 0; w < W; w++) {
+        // bit i of diagonal word w belongs to maze row 64 * w + i - 1
+        int rFirst = max(0, w * 64 - 1), rLast = min(rows, w * 64 + 63);
+        for (int d0 = rFirst; d0 < rLast - 1 + maze.numCols(); d0 += 64) {
+            for (int i = 0; i < 64; i++) {
+                int r = w * 64 + i - 1;
+                block[i] = r >= rFirst && r < rLast
+                         ? bitWindow(bits + size_t(r + 1) * mazeWords, mazeWords, d0 - r + 1) : 0;
+            }
+            transpose64(block);
+            for (int k = 0; k < 64 && d0 + k < D; k++) {
+                open.words[size_t(d0 + k + 1) * W + w] = block[k];
+            }
+        }
+    }
+}
+
+/*
+ * Index of the lowest set bit of a nonzero word.
+ */
+static inline int lowestBit(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/*
+ * Level-synchronous BFS over diagonal bitmaps. Right and down moves lead
+ * from diagonal p - 1 into p (bits r and r - 1), left and up moves from
+ * diagonal p + 1 (bits r and r + 1), so the next level of diagonal p is
+ *
+ *     (F[p-1] | F[p-1] << 1 | F[p+1] | F[p+1] >> 1) & open & ~visited
+ *
+ * where the shifts carry between the words of a diagonal. Carries out of a
+ * diagonal land on padding bits and are masked off.
+ *
+ * Walls make the frontier ragged, so most words of a diagonal are empty
+ * even where the search is active. Each diagonal therefore keeps a bitmask
+ * of its nonzero frontier words, and a level only visits words next to a
+ * nonzero word on an adjacent diagonal. Returns the level at which the
+ * exit was reached, or -1.
+ */
+static int bitParallelSearch(const FlatMaze& maze, bool keepLevels, DiagonalBits& visited,
+                             DiagonalBits& plane0, DiagonalBits& plane1) {
+    int rows = maze.numRows(), cols = maze.numCols();
+    if (rows == 0 || cols == 0)
+        return -1;
+    if (!maze.isOpen(0, 0) || !maze.isOpen(rows - 1, cols - 1))
+        return -1;
+    if (rows == 1 && cols == 1)
+        return 0;
+
+    DiagonalBits openBits(rows, cols);
+    skewOpenCells(maze, openBits);
+    const int D = openBits.numDiagonals;
+    const int W = openBits.wordsPerDiagonal;
+    const int M = (W + 63) / 64;                            // mask words per diagonal
+    const uint64_t lastMask = W % 64 ? (uint64_t(1) << (W % 64)) - 1 : ~uint64_t(0);
+    const uint64_t* open = openBits.words.data();
+    uint64_t* seen = visited.words.data();
+    uint64_t* level0 = plane0.words.data();
+    uint64_t* level1 = plane1.words.data();
+    // one spare word at each end for the carries of the outermost words
+    vector<uint64_t> frontierBits(openBits.words.size() + 2, 0), nextBits(frontierBits.size(), 0);
+    uint64_t* frontier = frontierBits.data() + 1;
+    uint64_t* next = nextBits.data() + 1;
+    vector<uint64_t> active(size_t(D + 2) * M, 0), nextActive(active.size(), 0);
+
+    frontier[visited.wordOf(0, 0)] = seen[visited.wordOf(0, 0)] = uint64_t(1) << 1;
+    active[1 * M] = 1;
+    int first = 1, last = 1;
+    size_t exitWord = visited.wordOf(rows - 1, cols - 1);
+    int exitBit = rows & 63;
+
+    for (int level = 1; first <= last; level++) {
+        // all-ones or all-zeros masks that write level % 3 into the planes
+        uint64_t code0 = (level % 3) & 1 ? ~uint64_t(0) : 0;
+        uint64_t code1 = (level % 3) & 2 ? ~uint64_t(0) : 0;
+        int newFirst = D + 1, newLast = 0;
+
+        for (int p = max(1, first - 1); p <= min(D, last + 1); p++) {
+            const uint64_t* before = &active[size_t(p - 1) * M];
+            const uint64_t* after = &active[size_t(p + 1) * M];
+            bool any = false;
+            for (int m = 0; m < M; m++) {
+                uint64_t src = before[m] | after[m];
+                uint64_t below = m > 0 ? before[m - 1] | after[m - 1] : 0;
+                uint64_t above = m + 1 < M ? before[m + 1] | after[m + 1] : 0;
+                uint64_t candidates = src | src << 1 | src >> 1 | below >> 63 | above << 63;
+                if (m == M - 1)
+                    candidates &= lastMask;
+                uint64_t found = 0;
+                while (candidates) {
+                    int j = lowestBit(candidates);
+                    size_t i = size_t(p) * W + size_t(m) * 64 + j;
+                    candidates &= candidates - 1;
+                    uint64_t pre = frontier[i - W], post = frontier[i + W];
+                    uint64_t n = (pre | (pre << 1) | (frontier[i - W - 1] >> 63)
+                                | post | (post >> 1) | (frontier[i + W + 1] << 63))
+                               & open[i] & ~seen[i];
+                    if (n == 0)
+                        continue;
+                    next[i] = n;
+                    seen[i] |= n;
+                    if (keepLevels) {
+                        level0[i] |= n & code0;
+                        level1[i] |= n & code1;
+                    }
+                    found |= uint64_t(1) << j;
+                }
+                nextActive[size_t(p) * M + m] = found;
+                any |= found != 0;
+            }
+            if (any) {
+                newFirst = min(newFirst, p);
+                newLast = p;
+            }
+        }
+
+        if (seen[exitWord] >> exitBit & 1)
+            return level;
+        // clear the old frontier so it can be reused for the level after next
+        for (int p = first; p <= last; p++) {
+            for (int m = 0; m < M; m++) {
+                uint64_t& mask = active[size_t(p) * M + m];
+                for (; mask; mask &= mask - 1) {
+                    frontier[size_t(p) * W + size_t(m) * 64 + lowestBit(mask)] = 0;
+                }
+            }
+        }
+        swap(frontier, next);
+        active.swap(nextActive);
+        first = newFirst;
+        last = newLast;
+    }
+    return -1;
+}
+
+int bitParallelDistance(const FlatMaze& maze) {
+    DiagonalBits visited(maze.numRows(), maze.numCols());
+    return bitParallelSearch(maze, false, visited, visited, visited);
+}
+
+Vector<GridLocation> solveMazeBitParallelBFS(const FlatMaze& maze, long& expanded) {
+    int rows = maze.numRows(), cols = maze.numCols();
+    DiagonalBits visited(rows, cols), plane0(rows, cols), plane1(rows, cols);
+    int length = bitParallelSearch(maze, true, visited, plane0, plane1);
+    expanded = 0;
+    for (uint64_t word : visited.words) {
+        expanded += bitset<64>(word).count();
+    }
+    if (length < 0)
+        return {};
+
+    // neighbors in a BFS differ by at most one level, so level mod 3 is
+    // enough to tell the one step back from the others
+    Vector<GridLocation> path(length + 1);
+    GridLocation cur = {rows - 1, cols - 1};
+    for (int level = length; level > 0; level--) {
+        path[level] = cur;
+        int want = (level - 1) % 3;
+        int moves = maze.neighborMask(maze.index(cur.row, cur.col));
+        for (int bit = MOVE_UP; bit <= MOVE_DOWN; bit <<= 1) {
+            GridLocation nb = moveLocation(cur, bit);
+            if ((moves & bit) && visited.bitOf(nb.row, nb.col)
+                    && (plane0.bitOf(nb.row, nb.col) | plane1.bitOf(nb.row, nb.col) << 1) == want) {
+                cur = nb;
+                break;
+            }
+        }
+    }
+    path[0] = cur;
+    return path;
+}
+
+/*
+ * Returns the bytes of per-cell state that solver allocates for maze. The
+ * queue, frontier lists or heap are left out, since their size depends on
+ * the shape of the maze rather than its area.
+ */
+static long solverBytes(const FlatMaze& maze, MazeSolver solver) {
+    long indices = maze.numIndices();
+    long words = indices / 64;
+    switch (solver) {
+        case SOLVER_FLAT_BFS:
+            return indices * sizeof(uint32_t) + words * sizeof(uint64_t);
+        case SOLVER_BIDIRECTIONAL_BFS:
+            return 2 * indices * sizeof(uint32_t);
+        case SOLVER_ASTAR:
+            return indices * sizeof(uint32_t);
+        case SOLVER_BIT_PARALLEL_BFS: {
+            // open, visited, two level planes and two frontiers
+            DiagonalBits diagonals(maze.numRows(), maze.numCols());
+            return 6 * long(diagonals.words.size()) * sizeof(uint64_t);
+        }
+        default:
+            return -1;
+    }
+}
+
+Vector<GridLocation> solveMaze(const FlatMaze& maze, MazeSolver solver, SolverStats& stats) {
+    Vector<GridLocation> path;
+    stats.bytes = solverBytes(maze, solver);
+    auto start = chrono::steady_clock::now();
+    switch (solver) {
+        case SOLVER_FLAT_BFS:
+            path = solveMazeFlatBFS(maze, stats.nodesExpanded);
+            break;
+        case SOLVER_BIDIRECTIONAL_BFS:
+            path = solveMazeBidirectionalBFS(maze, stats.nodesExpanded);
+            break;
+        case SOLVER_ASTAR:
+            path = solveMazeAStar(maze, stats.nodesExpanded);
+            break;
+        case SOLVER_BIT_PARALLEL_BFS:
+            path = solveMazeBitParallelBFS(maze, stats.nodesExpanded);
+            break;
+        default:
+            error("solveMaze: " + solverName(solver) + " needs a Grid<bool> maze");
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return path;
+}
+
+Vector<GridLocation> solveMaze(Grid<bool>& maze, MazeSolver solver, SolverStats& stats) {
+    if (solver != SOLVER_BFS && solver != SOLVER_DFS)
+        return solveMaze(FlatMaze(maze), solver, stats);
+
+    Vector<GridLocation> path;
+    stats.bytes = -1;
+    auto start = chrono::steady_clock::now();
+    if (solver == SOLVER_BFS)
+        path = searchMazeBFS(maze, stats.nodesExpanded);
+    else
+        path = searchMazeDFS(maze, stats.nodesExpanded);
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return path;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+static const Vector<MazeSolver> ALL_SOLVERS = {SOLVER_BFS, SOLVER_DFS, SOLVER_FLAT_BFS,
+                                               SOLVER_BIDIRECTIONAL_BFS, SOLVER_ASTAR,
+                                               SOLVER_BIT_PARALLEL_BFS};
+
+/* Test helper to make a rows x cols grid where each cell is open with the
+ * given percent chance; the entry and exit are always open. */
+static Grid<bool> randomOpenMaze(int rows, int cols, int openPercent) {
+    Grid<bool> maze(rows, cols);
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            maze[r][c] = randomInteger(1, 100) <= openPercent;
+        }
+    }
+    maze[0][0] = maze[rows - 1][cols - 1] = true;
+    return maze;
+}
+
+/* Test helper to solve maze with every solver, confirm that the solvers
+ * agree, and print one row per solver. */
+static void compareSolvers(string name, Grid<bool>& maze, Vector<MazeSolver> solvers) {
+    int shortest = -1;
+    for (MazeSolver solver : solvers) {
+        SolverStats stats;
+        Vector<GridLocation> path = solveMaze(maze, solver, stats);
+        if (solver != SOLVER_DFS) { // every other solver finds a shortest path
+            if (shortest == -1)
+                shortest = path.size();
+            EXPECT_EQUAL(path.size(), shortest);
+        }
+        if (!path.isEmpty())
+            EXPECT_NO_ERROR(validatePath(maze, path));
+        cout << "    " << setw(14) << left << name << setw(18) << solverName(solver) << right
+             << " expanded " << setw(9) << stats.nodesExpanded
+             << "  path " << setw(6) << path.size()
+             << "  " << fixed << setprecision(6) << stats.seconds << " s" << endl;
+    }
+}
+
+STUDENT_TEST("Every solver solves the small hand-built mazes") {
+    Grid<bool> maze = {{true, true, false},
+                       {false, true, false},
+                       {true, true, true}};
+    Vector<GridLocation> sol = { {0,0}, {0,1}, {1,1}, {2,1}, {2,2} };
+    for (MazeSolver solver : ALL_SOLVERS) {
+        SolverStats stats;
+        EXPECT_EQUAL(solveMaze(maze, solver, stats), sol);
+    }
+
+    Grid<bool> one = {{true}};
+    Grid<bool> blocked = {{true, false},
+                          {false, true}};
+    for (MazeSolver solver : ALL_SOLVERS) {
+        SolverStats stats;
+        EXPECT_EQUAL(solveMaze(one, solver, stats).size(), 1);
+        if (solver != SOLVER_BFS && solver != SOLVER_DFS)
+            EXPECT(solveMaze(blocked, solver, stats).isEmpty());
+    }
+}
+
+STUDENT_TEST("Shortest-path solvers agree on random open grids") {
+    for (int trial = 0; trial < 20; trial++) {
+        Grid<bool> maze = randomOpenMaze(randomInteger(2, 40), randomInteger(2, 40), 65);
+        SolverStats stats;
+        int bfs = solveMaze(maze, SOLVER_FLAT_BFS, stats).size();
+        EXPECT_EQUAL(solveMaze(maze, SOLVER_BIDIRECTIONAL_BFS, stats).size(), bfs);
+        EXPECT_EQUAL(solveMaze(maze, SOLVER_ASTAR, stats).size(), bfs);
+        EXPECT_EQUAL(solveMaze(maze, SOLVER_BIT_PARALLEL_BFS, stats).size(), bfs);
+        EXPECT_EQUAL(bitParallelDistance(FlatMaze(maze)), bfs - 1);
+    }
+}
+
+STUDENT_TEST("Compare solvers on maze files and generated mazes") {
+    Vector<string> files = {"res/5x7.maze", "res/13x39.maze", "res/17x37.maze", "res/19x35.maze",
+                            "res/21x23.maze", "res/21x25.maze", "res/21x35.maze", "res/25x15.maze",
+                            "res/25x33.maze", "res/33x41.maze"};
+    for (string file : files) {
+        Grid<bool> maze;
+        readMazeFile(file, maze);
+        compareSolvers(file.substr(4), maze, ALL_SOLVERS);
+    }
+
+    setRandomSeed(106);
+    Grid<bool> small = randomOpenMaze(101, 101, 70);
+    compareSolvers("random 101^2", small, ALL_SOLVERS);
+
+    // the path-copying BFS/DFS need too much memory beyond this size
+    Vector<MazeSolver> flatSolvers = {SOLVER_FLAT_BFS, SOLVER_BIDIRECTIONAL_BFS, SOLVER_ASTAR,
+                                      SOLVER_BIT_PARALLEL_BFS};
+    Grid<bool> large;
+    SolverStats stats;
+    do { // regenerate until the entry is not walled off
+        large = randomOpenMaze(1001, 1001, 70);
+    } while (solveMaze(large, SOLVER_FLAT_BFS, stats).isEmpty());
+    compareSolvers("random 1001^2", large, flatSolvers);
+}
+
+STUDENT_TEST("bitParallelDistance crosses word boundaries and walls") {
+    // 130 columns spans three words per row; the wall column forces a detour
+    Grid<bool> maze(3, 130, true);
+    for (int r = 0; r < 2; r++) {
+        maze[r][70] = false;
+    }
+    EXPECT_EQUAL(bitParallelDistance(FlatMaze(maze)), 2 + 129);
+    long expanded;
+    Vector<GridLocation> path = solveMazeBitParallelBFS(FlatMaze(maze), expanded);
+    EXPECT_EQUAL(path.size(), 2 + 129 + 1);
+    EXPECT_NO_ERROR(validatePath(maze, path));
+    // the search stops at the exit's level, before the cells beyond it
+    EXPECT(expanded >= path.size() && expanded < 3 * 130 - 2);
+
+    maze[2][70] = false;
+    EXPECT_EQUAL(bitParallelDistance(FlatMaze(maze)), -1);
+    EXPECT_EQUAL(bitParallelDistance(FlatMaze()), -1);
+    EXPECT_EQUAL(bitParallelDistance(FlatMaze(Grid<bool>(1, 1, true))), 0);
+}
+
+STUDENT_TEST("Bit-parallel BFS against flat BFS on a 4096^2 open grid") {
+    setRandomSeed(4096);
+    int n = 4096;
+    FlatMaze maze;
+    long expanded;
+    do {
+        maze = FlatMaze(randomOpenMaze(n, n, 90));
+    } while (solveMazeFlatBFS(maze).isEmpty());
+
+    Vector<GridLocation> path;
+    int distance = 0;
+    TIME_OPERATION(n * n, path = solveMazeFlatBFS(maze, expanded));
+    TIME_OPERATION(n * n, distance = bitParallelDistance(maze));
+    EXPECT_EQUAL(distance, path.size() - 1);
+    TIME_OPERATION(n * n, path = solveMazeBitParallelBFS(maze, expanded));
+    EXPECT_EQUAL(distance, path.size() - 1);
+}
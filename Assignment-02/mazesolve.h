@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include "flatmaze.h"
+#include "grid.h"
+#include "vector.h"
+
+/*
+ * Strategies for solving a maze from the top left to the bottom right.
+ * BFS and DFS are the path-copying searches in maze.cpp; the others run
+ * on a FlatMaze and return shortest paths.
+ */
+enum MazeSolver {
+    SOLVER_BFS,
+    SOLVER_DFS,
+    SOLVER_FLAT_BFS,
+    SOLVER_BIDIRECTIONAL_BFS,
+    SOLVER_ASTAR,
+    SOLVER_BIT_PARALLEL_BFS
+};
+
+std::string solverName(MazeSolver solver);
+
+struct SolverStats {
+    long nodesExpanded;     // cells (paths, for BFS/DFS) taken off the open list
+    double seconds;         // wall time of the search, excluding conversion
+    long bytes;             // size of the per-cell arrays, or -1 for BFS/DFS
+};
+
+/*
+ * Solves maze with the chosen strategy and fills in stats. Returns an empty
+ * path if the exit cannot be reached. The FlatMaze version does not
+ * support SOLVER_BFS or SOLVER_DFS.
+ */
+Vector<GridLocation> solveMaze(Grid<bool>& maze, MazeSolver solver, SolverStats& stats);
+Vector<GridLocation> solveMaze(const FlatMaze& maze, MazeSolver solver, SolverStats& stats);
+
+/*
+ * Breadth-first search from both the entry and the exit, one whole level
+ * at a time from whichever side has the smaller frontier, stopping after
+ * the first level in which the two searches meet.
+ */
+Vector<GridLocation> solveMazeBidirectionalBFS(const FlatMaze& maze, long& expanded);
+
+/*
+ * A* search with the Manhattan distance to the exit as heuristic and a
+ * binary heap as open list. Ties on f prefer the deeper cell.
+ */
+Vector<GridLocation> solveMazeAStar(const FlatMaze& maze, long& expanded);
+
+/*
+ * Breadth-first search that expands the whole frontier a 64-bit word at a
+ * time: the next level is the frontier shifted one cell in each
+ * direction, masked by the open cells not yet visited. The bitmaps are
+ * stored by anti-diagonal, which is where a search from the corner keeps
+ * its frontier, and only words next to the current frontier are touched
+ * on each level. Suited to dense open mazes; on long one-cell corridors
+ * the per-level overhead makes the queue-based solvers faster.
+ *
+ * bitParallelDistance returns the number of steps on a shortest path, or
+ * -1 if the exit cannot be reached. solveMazeBitParallelBFS also records
+ * each cell's level mod 3 in two bit planes, enough to walk back from the
+ * exit one level at a time, and sets expanded to the number of cells reached.
+ */
+int bitParallelDistance(const FlatMaze& maze);
+Vector<GridLocation> solveMazeBitParallelBFS(const FlatMaze& maze, long& expanded);
@@ -0,0 +1,159 @@
+/*
+ * Reusable maze path validator for checking large numbers of paths.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include "error.h"
+#include "maze.h"
+#include "mazegen.h"
+#include "pathvalidator.h"
+#include "random.h"
+#include "set.h"
+#include "SimpleTest.h"
+using namespace std;
+
+PathValidator::PathValidator(const Grid<bool>& maze) : PathValidator(FlatMaze(maze)) {
+}
+
+PathValidator::PathValidator(FlatMaze maze) : _maze(std::move(maze)) {
+    _visitedIn.assign(_maze.numIndices(), 0);
+    _epoch = 0;
+}
+
+const char* PathValidator::findProblem(const Vector<GridLocation>& path) {
+    if (path.isEmpty())
+        return "Path is empty!";
+    int rows = _maze.numRows(), cols = _maze.numCols();
+    GridLocation first = path[0], last = path[path.size() - 1];
+    if (first.row != 0 || first.col != 0)
+        return "Doesn't start top left.";
+    if (last.row != rows - 1 || last.col != cols - 1)
+        return "Doesn't end in bottom left.";
+
+    if (++_epoch == 0) {
+        // the stamps have wrapped around; clear them once every 2^32 paths
+        fill(_visitedIn.begin(), _visitedIn.end(), 0);
+        _epoch = 1;
+    }
+    _visitedIn[_maze.index(0, 0)] = _epoch;
+    for (int i = 1; i < path.size(); i++) {
+        GridLocation prev = path[i - 1], cur = path[i];
+        // one step in one direction, onto an open cell inside the maze
+        if (abs(cur.row - prev.row) + abs(cur.col - prev.col) != 1
+                || unsigned(cur.row) >= unsigned(rows) || unsigned(cur.col) >= unsigned(cols))
+            return "Invalid path";
+        uint32_t index = _maze.index(cur.row, cur.col);
+        if (!_maze.isOpen(index))
+            return "Invalid path";
+        if (_visitedIn[index] == _epoch)
+            return "Already visited";
+        _visitedIn[index] = _epoch;
+    }
+    return nullptr;
+}
+
+void PathValidator::validate(const Vector<GridLocation>& path) {
+    const char* problem = findProblem(path);
+    if (problem != nullptr)
+        error(problem);
+}
+
+Vector<int> PathValidator::findInvalidPaths(const Vector<Vector<GridLocation>>& paths) {
+    Vector<int> invalid;
+    for (int i = 0; i < paths.size(); i++) {
+        if (findProblem(paths[i]) != nullptr)
+            invalid.add(i);
+    }
+    return invalid;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper with the original rules of validatePath, checked with
+ * generateValidMoves and a Set of visited locations, for comparison. */
+static bool referenceValid(Grid<bool>& maze, const Vector<GridLocation>& path) {
+    if (path.isEmpty() || !(path[0] == GridLocation{0, 0})
+            || !(path[path.size() - 1] == GridLocation{maze.numRows() - 1, maze.numCols() - 1}))
+        return false;
+    Set<GridLocation> visited = {path[0]};
+    for (int i = 0; i + 1 < path.size(); i++) {
+        if (!generateValidMoves(maze, path[i]).contains(path[i + 1]) || visited.contains(path[i + 1]))
+            return false;
+        visited.add(path[i + 1]);
+    }
+    return true;
+}
+
+STUDENT_TEST("PathValidator reports the same problems as validatePath") {
+    Grid<bool> maze = {{true, true, false},
+                       {true, true, true},
+                       {false, true, true}};
+    PathValidator validator(maze);
+    EXPECT_EQUAL(string(validator.findProblem({})), "Path is empty!");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 1}, {1, 1}, {2, 1}, {2, 2} })), "Doesn't start top left.");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 0}, {1, 0}, {1, 1} })), "Doesn't end in bottom left.");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 0}, {1, 1}, {2, 2} })), "Invalid path");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 0}, {1, 0}, {2, 0}, {2, 1}, {2, 2} })), "Invalid path");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 0}, {1, 0}, {1, -1}, {1, 0}, {2, 2} })), "Invalid path");
+    EXPECT_EQUAL(string(validator.findProblem({ {0, 0}, {0, 1}, {0, 0}, {1, 0}, {1, 1}, {2, 1}, {2, 2} })),
+                 "Already visited");
+    EXPECT(validator.findProblem({ {0, 0}, {0, 1}, {1, 1}, {1, 2}, {2, 2} }) == nullptr);
+
+    // cells visited by an earlier path do not count as visited by the next
+    EXPECT(validator.findProblem({ {0, 0}, {1, 0}, {1, 1}, {2, 1}, {2, 2} }) == nullptr);
+    EXPECT_ERROR(validator.validate({ {0, 0}, {1, 1}, {2, 2} }));
+    EXPECT_NO_ERROR(validator.validate({ {0, 0}, {0, 1}, {1, 1}, {2, 1}, {2, 2} }));
+}
+
+STUDENT_TEST("PathValidator batch agrees with the original rules on mutated paths") {
+    Grid<bool> maze;
+    generateMaze(GEN_OPEN_ROOMS, 31, 47, 35, maze);
+    Vector<GridLocation> good = solveMazeFlatBFS(maze);
+
+    Vector<Vector<GridLocation>> paths;
+    for (int i = 0; i < 500; i++) {
+        Vector<GridLocation> path = good;
+        int at = randomInteger(0, path.size() - 1);
+        switch (randomInteger(0, 3)) {
+            case 0: path[at].row += randomInteger(-1, 1); break;
+            case 1: path[at].col += randomInteger(-1, 1); break;
+            case 2: path.insert(at, path[randomInteger(0, path.size() - 1)]); break;
+            case 3: path.remove(at); break;
+        }
+        paths.add(path);
+    }
+    Vector<int> expected;
+    for (int i = 0; i < paths.size(); i++) {
+        if (!referenceValid(maze, paths[i]))
+            expected.add(i);
+    }
+    EXPECT_EQUAL(PathValidator(maze).findInvalidPaths(paths), expected);
+    EXPECT(!expected.isEmpty() && expected.size() < paths.size());
+
+    // the one-shot validatePath keeps its own visited bits, with the same rules
+    for (int i = 0; i < paths.size(); i++) {
+        if (!referenceValid(maze, paths[i]))
+            EXPECT_ERROR(validatePath(maze, paths[i]));
+        else
+            EXPECT_NO_ERROR(validatePath(maze, paths[i]));
+    }
+}
+
+STUDENT_TEST("Time PathValidator on many paths in a large maze") {
+    FlatMaze maze;
+    generateMaze(GEN_BACKTRACKER, 501, 501, 35, maze);
+    Vector<GridLocation> path = solveMazeFlatBFS(maze);
+    Vector<Vector<GridLocation>> paths;
+    for (int i = 0; i < 100; i++) {
+        paths.add(path);
+    }
+    PathValidator validator(maze);
+    TIME_OPERATION(paths.size() * path.size(), validator.findInvalidPaths(paths));
+    EXPECT(validator.findInvalidPaths(paths).isEmpty());
+
+    Grid<bool> grid;
+    generateMaze(GEN_BACKTRACKER, 501, 501, 35, grid);
+    TIME_OPERATION(path.size(), validatePath(grid, path));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "flatmaze.h"
+#include "grid.h"
+#include "vector.h"
+
+/**
+ * Checks candidate solution paths against one maze, with the same rules
+ * and error messages as validatePath. The maze is converted once, and each
+ * step of a path costs O(1): an adjacency test by coordinate difference,
+ * one bit test for an open cell, and one compare for a repeated cell.
+ *
+ * Visited cells are marked with the number (epoch) of the path being
+ * checked rather than true/false, so starting the next path only bumps
+ * the epoch instead of clearing the array.
+ */
+class PathValidator {
+public:
+    explicit PathValidator(const Grid<bool>& maze);
+    explicit PathValidator(FlatMaze maze);
+
+    /**
+     * Raises an error describing the first problem if path is not a valid
+     * solution.
+     */
+    void validate(const Vector<GridLocation>& path);
+
+    /**
+     * Returns a description of the first problem with path, or nullptr if
+     * it is a valid solution. Does not raise errors, which makes it the
+     * cheaper choice when many paths are expected to fail.
+     */
+    const char* findProblem(const Vector<GridLocation>& path);
+
+    /**
+     * Checks every path and returns the indices of the ones that are not
+     * valid solutions, in increasing order.
+     */
+    Vector<int> findInvalidPaths(const Vector<Vector<GridLocation>>& paths);
+
+private:
+    FlatMaze _maze;
+    std::vector<uint32_t> _visitedIn;   // epoch of the last path through each cell
+    uint32_t _epoch;
+};
@@ -0,0 +1,354 @@
+/*
+ * Positional inverted index supporting exact-phrase and NEAR/k queries.
+ * Positions are stored compressed and only decoded for pages that pass
+ * the doc-level intersection.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include "error.h"
+#include "posindex.h"
+#include "search.h"
+#include "strlib.h"
+#include "SimpleTest.h"
+using namespace std;
+
+// Appends n to bytes as a little-endian base-128 varint.
+static void appendVarint(vector<unsigned char>& bytes, int n) {
+    unsigned int v = n;
+    while (v >= 0x80) {
+        bytes.push_back((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    bytes.push_back(v);
+}
+
+bool parsePositionalQuery(string query, PositionalQuery& result) {
+    query = trim(query);
+    if (query.size() >= 2 && query[0] == '"' && query[query.size() - 1] == '"') {
+        Vector<string> terms = gatherTokenSequence(query.substr(1, query.size() - 2));
+        if (terms.isEmpty())
+            return false;
+        result.kind = PHRASE_QUERY;
+        result.terms = terms;
+        result.distance = 0;
+        return true;
+    }
+
+    Vector<string> words;
+    for (string w : stringSplit(query, " ")) {
+        if (!w.empty())
+            words.add(w);
+    }
+    if (words.size() != 3 || toUpperCase(words[1]).find("NEAR/") != 0)
+        return false;
+    string k = words[1].substr(5);
+    if (k.empty() || k.find_first_not_of("0123456789") != string::npos)
+        return false;
+    string a = cleanToken(words[0]), b = cleanToken(words[2]);
+    if (a.empty() || b.empty())
+        return false;
+    result.kind = NEAR_QUERY;
+    result.terms = {a, b};
+    result.distance = atoi(k.c_str());
+    return true;
+}
+
+string positionalQueryKey(const PositionalQuery& query) {
+    if (query.kind == NEAR_QUERY)
+        return query.terms[0] + " NEAR/" + integerToString(query.distance) + " " + query.terms[1];
+    string key = "\"";
+    for (int i = 0; i < query.terms.size(); i++) {
+        if (i > 0)
+            key += ' ';
+        key += query.terms[i];
+    }
+    return key + "\"";
+}
+
+PositionalIndex::PositionalIndex() {
+    _decoded = 0;
+}
+
+/*
+ * Tokenizes each page in order, collecting the positions of every term,
+ * then appends the page to each term's posting list. Pages are visited in
+ * doc ID order, so every doc ID list comes out sorted.
+ */
+int PositionalIndex::build(Vector<string>& lines) {
+    _postings.clear();
+    _urls.clear();
+    for (int i = 0; i + 1 < lines.size(); i += 2) {
+        int docId = _urls.size();
+        _urls.add(lines[i]);
+
+        Vector<string> tokens = gatherTokenSequence(lines[i + 1]);
+        map<string, vector<int>> positions;
+        for (int pos = 0; pos < tokens.size(); pos++) {
+            positions[tokens[pos]].push_back(pos);
+        }
+        for (auto& entry : positions) {
+            PostingList& list = _postings[entry.first];
+            if (list.offsets.empty())
+                list.offsets.push_back(0);
+            list.docIds.push_back(docId);
+            int prev = 0;
+            for (int pos : entry.second) {
+                appendVarint(list.bytes, pos - prev);
+                prev = pos;
+            }
+            list.offsets.push_back(list.bytes.size());
+        }
+    }
+    return _urls.size();
+}
+
+int PositionalIndex::numPages() const {
+    return _urls.size();
+}
+
+int PositionalIndex::numTerms() const {
+    return _postings.size();
+}
+
+string PositionalIndex::url(int docId) const {
+    return _urls[docId];
+}
+
+int PositionalIndex::positionListsDecoded() const {
+    return _decoded;
+}
+
+const PositionalIndex::PostingList* PositionalIndex::find(const string& term) const {
+    auto found = _postings.find(term);
+    return found == _postings.end() ? nullptr : &found->second;
+}
+
+/*
+ * Decodes the positions of the i-th doc in list.
+ */
+void PositionalIndex::decodePositions(const PostingList& list, int i, vector<int>& positions) const {
+    positions.clear();
+    int end = list.offsets[i + 1];
+    int pos = 0;
+    for (int b = list.offsets[i]; b < end; ) {
+        unsigned int delta = 0;
+        int shift = 0;
+        unsigned char byte;
+        do {
+            byte = list.bytes[b++];
+            delta |= (byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        pos += delta;
+        positions.push_back(pos);
+    }
+    _decoded++;
+}
+
+Vector<int> PositionalIndex::docsContaining(string term) const {
+    Vector<int> docs;
+    const PostingList* list = find(cleanToken(term));
+    if (list != nullptr) {
+        for (int doc : list->docIds) {
+            docs.add(doc);
+        }
+    }
+    return docs;
+}
+
+/*
+ * Intersects the doc ID lists, driven by the shortest one. Returns the
+ * common doc IDs; where[d][t] is the index of the d-th common doc within
+ * lists[t], so positions can be decoded without searching again.
+ */
+vector<int> PositionalIndex::intersectDocs(const Vector<const PostingList*>& lists,
+                                           vector<vector<int>>& where) const {
+    int shortest = 0;
+    for (int t = 1; t < lists.size(); t++) {
+        if (lists[t]->docIds.size() < lists[shortest]->docIds.size())
+            shortest = t;
+    }
+
+    vector<int> docs;
+    vector<int> cursor(lists.size(), 0);
+    for (int doc : lists[shortest]->docIds) {
+        vector<int> at(lists.size(), 0);
+        bool inAll = true;
+        for (int t = 0; t < lists.size() && inAll; t++) {
+            const vector<int>& ids = lists[t]->docIds;
+            auto it = lower_bound(ids.begin() + cursor[t], ids.end(), doc);
+            cursor[t] = it - ids.begin();
+            inAll = it != ids.end() && *it == doc;
+            at[t] = cursor[t];
+        }
+        if (inAll) {
+            docs.push_back(doc);
+            where.push_back(at);
+        }
+    }
+    return docs;
+}
+
+/*
+ * A page matches the phrase if some position p has term t at p + t for
+ * every t. Candidates start as the positions of the first term and are
+ * filtered term by term; once none remain, later terms are not decoded.
+ */
+Vector<int> PositionalIndex::matchPhrase(const Vector<const PostingList*>& lists) const {
+    vector<vector<int>> where;
+    vector<int> docs = intersectDocs(lists, where);
+    Vector<int> result;
+    vector<int> candidates, positions, kept;
+
+    for (size_t d = 0; d < docs.size(); d++) {
+        decodePositions(*lists[0], where[d][0], candidates);
+        for (int t = 1; t < lists.size() && !candidates.empty(); t++) {
+            decodePositions(*lists[t], where[d][t], positions);
+            kept.clear();
+            size_t j = 0;
+            for (int start : candidates) {
+                while (j < positions.size() && positions[j] < start + t)
+                    j++;
+                if (j < positions.size() && positions[j] == start + t)
+                    kept.push_back(start);
+            }
+            candidates.swap(kept);
+        }
+        if (!candidates.empty())
+            result.add(docs[d]);
+    }
+    return result;
+}
+
+/*
+ * A page matches if some pair of positions of the two terms is at most
+ * distance apart. Both position lists are sorted, so one merge-style scan
+ * finds the closest pairs.
+ */
+Vector<int> PositionalIndex::matchNear(const Vector<const PostingList*>& lists, int distance) const {
+    vector<vector<int>> where;
+    vector<int> docs = intersectDocs(lists, where);
+    Vector<int> result;
+    vector<int> a, b;
+
+    for (size_t d = 0; d < docs.size(); d++) {
+        decodePositions(*lists[0], where[d][0], a);
+        decodePositions(*lists[1], where[d][1], b);
+        size_t i = 0, j = 0;
+        bool found = false;
+        while (i < a.size() && j < b.size() && !found) {
+            found = abs(a[i] - b[j]) <= distance;
+            if (a[i] < b[j])
+                i++;
+            else
+                j++;
+        }
+        if (found)
+            result.add(docs[d]);
+    }
+    return result;
+}
+
+Vector<int> PositionalIndex::match(const PositionalQuery& query) const {
+    Vector<const PostingList*> lists;
+    for (string term : query.terms) {
+        const PostingList* list = find(term);
+        if (list == nullptr)
+            return {};
+        lists.add(list);
+    }
+    if (lists.size() == 1)
+        return docsContaining(query.terms[0]);
+    if (query.kind == NEAR_QUERY)
+        return matchNear(lists, query.distance);
+    return matchPhrase(lists);
+}
+
+Set<string> PositionalIndex::findMatches(string query) const {
+    PositionalQuery parsed;
+    if (!parsePositionalQuery(query, parsed))
+        error("Not a phrase or NEAR query: " + query);
+    Set<string> result;
+    for (int docId : match(parsed)) {
+        result.add(_urls[docId]);
+    }
+    return result;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+STUDENT_TEST("parsePositionalQuery recognizes phrase and NEAR queries") {
+    PositionalQuery query;
+    EXPECT(parsePositionalQuery("\"Red  Fish!\"", query));
+    EXPECT_EQUAL(query.kind, PHRASE_QUERY);
+    EXPECT_EQUAL(positionalQueryKey(query), "\"red fish\"");
+    EXPECT(parsePositionalQuery("one near/3 Fish", query));
+    EXPECT_EQUAL(query.kind, NEAR_QUERY);
+    EXPECT_EQUAL(query.distance, 3);
+    EXPECT_EQUAL(positionalQueryKey(query), "one NEAR/3 fish");
+    EXPECT(!parsePositionalQuery("red +fish", query));
+    EXPECT(!parsePositionalQuery("red NEAR/x fish", query));
+}
+
+STUDENT_TEST("PositionalIndex phrase queries on tiny.txt") {
+    Vector<string> lines;
+    readDatabaseFile("res/tiny.txt", lines);
+    PositionalIndex index;
+    EXPECT_EQUAL(index.build(lines), 4);
+    EXPECT_EQUAL(index.numTerms(), 12);
+
+    EXPECT_EQUAL(index.findMatches("\"red fish\""), {"www.dr.seuss.net"});
+    EXPECT_EQUAL(index.findMatches("\"one fish two fish\""), {"www.dr.seuss.net"});
+    EXPECT_EQUAL(index.findMatches("\"eat fish\""), {"www.bigbadwolf.com"});
+    EXPECT_EQUAL(index.findMatches("\"fish red\""), {"www.dr.seuss.net"});
+    EXPECT(index.findMatches("\"fish one\"").isEmpty());
+    EXPECT(index.findMatches("\"fish eat\"").isEmpty());
+    EXPECT(index.findMatches("\"red hippo\"").isEmpty());
+    EXPECT_EQUAL(index.findMatches("\"fish\"").size(), 3);
+}
+
+STUDENT_TEST("PositionalIndex NEAR queries on tiny.txt") {
+    Vector<string> lines;
+    readDatabaseFile("res/tiny.txt", lines);
+    PositionalIndex index;
+    index.build(lines);
+
+    EXPECT_EQUAL(index.findMatches("red NEAR/1 green"), {"www.rainbow.org"});
+    EXPECT(index.findMatches("red NEAR/1 blue").isEmpty());
+    EXPECT_EQUAL(index.findMatches("blue NEAR/2 red"), {"www.rainbow.org", "www.dr.seuss.net"});
+    EXPECT_EQUAL(index.findMatches("milk NEAR/2 bread"), {"www.shoppinglist.com"});
+    EXPECT(index.findMatches("milk NEAR/1 bread").isEmpty());
+    EXPECT_ERROR(index.findMatches("milk bread"));
+}
+
+STUDENT_TEST("PositionalIndex decodes positions only for pages containing every term") {
+    Vector<string> lines;
+    readDatabaseFile("res/tiny.txt", lines);
+    PositionalIndex index;
+    index.build(lines);
+
+    // fish is on 3 pages but only one has one too
+    index.findMatches("\"fish one\"");
+    EXPECT_EQUAL(index.positionListsDecoded(), 2);
+}
+
+STUDENT_TEST("PositionalIndex on website.txt") {
+    Vector<string> lines;
+    readDatabaseFile("res/website.txt", lines);
+    PositionalIndex index;
+    EXPECT_EQUAL(index.build(lines), 36);
+    TIME_OPERATION(lines.size(), index.build(lines));
+
+    // every phrase match must also be a NEAR/1 match and an AND match
+    Map<string, Set<string>> terms;
+    buildIndex(lines, terms);
+    Set<string> phrase = index.findMatches("\"section leader\"");
+    Set<string> near = index.findMatches("section NEAR/1 leader");
+    Set<string> both = findQueryMatches(terms, "section +leader");
+    for (string url : phrase) {
+        EXPECT(near.contains(url));
+        EXPECT(both.contains(url));
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "set.h"
+#include "vector.h"
+
+/*
+ * A phrase query ("red fish") matches pages where the terms appear next to
+ * each other in order. A NEAR query (red NEAR/2 fish) matches pages where
+ * the two terms appear at most k tokens apart, in either order.
+ */
+enum PositionalKind { PHRASE_QUERY, NEAR_QUERY };
+
+struct PositionalQuery {
+    PositionalKind kind;
+    Vector<std::string> terms;  // cleaned terms
+    int distance;               // k for NEAR queries
+};
+
+/*
+ * Parses query as a phrase or NEAR query. Returns false, leaving result
+ * unchanged, if query is neither.
+ */
+bool parsePositionalQuery(std::string query, PositionalQuery& result);
+
+/*
+ * Returns a canonical string for a positional query, used as its cache key.
+ */
+std::string positionalQueryKey(const PositionalQuery& query);
+
+/**
+ * Inverted index that records where each term occurs on each page.
+ *
+ * For every term the index keeps the sorted list of doc IDs that contain
+ * it, plus the positions of the term within each of those pages. Positions
+ * are delta-encoded as variable-length integers, and each page's positions
+ * can be decoded independently of the others. A query first intersects the
+ * doc ID lists and only decodes positions for pages that survive.
+ */
+class PositionalIndex {
+public:
+    PositionalIndex();
+
+    /**
+     * Indexes a database in the format read by readDatabaseFile, replacing
+     * any previous contents. Doc IDs are page positions in the file, the
+     * same numbering searchEngine uses. Returns the number of pages.
+     */
+    int build(Vector<std::string>& lines);
+
+    int numPages() const;
+    int numTerms() const;
+    std::string url(int docId) const;
+
+    /**
+     * Returns the sorted doc IDs of pages that contain term.
+     */
+    Vector<int> docsContaining(std::string term) const;
+
+    /**
+     * Returns the sorted doc IDs of pages matching a phrase or NEAR query.
+     */
+    Vector<int> match(const PositionalQuery& query) const;
+
+    /**
+     * Parses and runs a positional query, returning matching URLs. Calls
+     * error() if query is not a phrase or NEAR query.
+     */
+    Set<std::string> findMatches(std::string query) const;
+
+    /*
+     * Number of per-page position lists decoded so far, for testing that
+     * rejected pages are skipped.
+     */
+    int positionListsDecoded() const;
+
+private:
+    struct PostingList {
+        std::vector<int> docIds;            // sorted
+        std::vector<int> offsets;           // start of each doc's positions in bytes; one extra at end
+        std::vector<unsigned char> bytes;   // varint position deltas
+    };
+
+    std::map<std::string, PostingList> _postings;
+    Vector<std::string> _urls;
+    mutable int _decoded;
+
+    const PostingList* find(const std::string& term) const;
+    void decodePositions(const PostingList& list, int i, std::vector<int>& positions) const;
+    std::vector<int> intersectDocs(const Vector<const PostingList*>& lists, std::vector<std::vector<int>>& where) const;
+    Vector<int> matchPhrase(const Vector<const PostingList*>& lists) const;
+    Vector<int> matchNear(const Vector<const PostingList*>& lists, int distance) const;
+};
@@ -0,0 +1,198 @@
+/*
+ * LRU cache of search engine results, bounded by bytes and invalidated
+ * whenever the index generation changes.
+ */
+
+#include <chrono>
+#include <iostream>
+#include "querycache.h"
+#include "SimpleTest.h"
+using namespace std;
+
+// approximate bookkeeping cost of one entry (list node, hash node, Vector header)
+static const int ENTRY_OVERHEAD = 96;
+
+// Returns a monotonic timestamp in microseconds.
+static double nowMicros() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QueryCache::QueryCache(int maxBytes) {
+    _maxBytes = maxBytes;
+    _bytesUsed = 0;
+    _generation = 0;
+    _pendingStart = 0;
+    _hits = _misses = _evictions = _invalidations = 0;
+    _hitMicros = _missMicros = 0;
+    _timedMisses = 0;
+}
+
+/*
+ * Drops all entries if they were computed against a different index
+ * generation than the caller is using now.
+ */
+void QueryCache::checkGeneration(int generation) {
+    if (generation != _generation) {
+        if (!_entries.empty())
+            _invalidations++;
+        clear();
+        _generation = generation;
+    }
+}
+
+bool QueryCache::lookup(const string& key, int generation, Vector<int>& docIds) {
+    double start = nowMicros();
+    checkGeneration(generation);
+
+    auto found = _lookup.find(key);
+    if (found == _lookup.end()) {
+        _misses++;
+        _pendingKey = key;
+        _pendingStart = start;
+        return false;
+    }
+
+    // move entry to front of the recency list
+    _entries.splice(_entries.begin(), _entries, found->second);
+    docIds = found->second->docIds;
+    _hits++;
+    _hitMicros += nowMicros() - start;
+    return true;
+}
+
+void QueryCache::store(const string& key, int generation, const Vector<int>& docIds) {
+    checkGeneration(generation);
+    if (key == _pendingKey) {
+        _missMicros += nowMicros() - _pendingStart;
+        _timedMisses++;
+        _pendingKey.clear();
+    }
+
+    int bytes = ENTRY_OVERHEAD + key.size() + docIds.size() * sizeof(int);
+    if (bytes > _maxBytes)
+        return;
+
+    auto found = _lookup.find(key);
+    if (found != _lookup.end()) {
+        _bytesUsed -= found->second->bytes;
+        _entries.erase(found->second);
+        _lookup.erase(found);
+    }
+    while (_bytesUsed + bytes > _maxBytes) {
+        evictLast();
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.docIds = docIds;
+    entry.bytes = bytes;
+    _entries.push_front(entry);
+    _lookup[key] = _entries.begin();
+    _bytesUsed += bytes;
+}
+
+/*
+ * Removes the least recently used entry.
+ */
+void QueryCache::evictLast() {
+    Entry& last = _entries.back();
+    _bytesUsed -= last.bytes;
+    _lookup.erase(last.key);
+    _entries.pop_back();
+    _evictions++;
+}
+
+void QueryCache::clear() {
+    _entries.clear();
+    _lookup.clear();
+    _bytesUsed = 0;
+}
+
+int QueryCache::size() const {
+    return _entries.size();
+}
+
+int QueryCache::bytesUsed() const {
+    return _bytesUsed;
+}
+
+int QueryCache::hits() const {
+    return _hits;
+}
+
+int QueryCache::misses() const {
+    return _misses;
+}
+
+int QueryCache::evictions() const {
+    return _evictions;
+}
+
+int QueryCache::invalidations() const {
+    return _invalidations;
+}
+
+double QueryCache::hitRate() const {
+    int total = _hits + _misses;
+    return total == 0 ? 0 : double(_hits) / total;
+}
+
+double QueryCache::averageHitMicros() const {
+    return _hits == 0 ? 0 : _hitMicros / _hits;
+}
+
+double QueryCache::averageMissMicros() const {
+    return _timedMisses == 0 ? 0 : _missMicros / _timedMisses;
+}
+
+void QueryCache::printStats() const {
+    cout << "Query cache: " << size() << " entries, " << bytesUsed() << "/" << _maxBytes << " bytes" << endl;
+    cout << "  hits " << hits() << ", misses " << misses() << ", hit rate " << hitRate() << endl;
+    cout << "  avg hit " << averageHitMicros() << " us, avg miss " << averageMissMicros() << " us" << endl;
+    cout << "  evictions " << evictions() << ", invalidations " << invalidations() << endl;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+STUDENT_TEST("QueryCache hit and miss") {
+    QueryCache cache(QUERY_CACHE_BYTES);
+    Vector<int> ids;
+    EXPECT(!cache.lookup("red +fish", 1, ids));
+    cache.store("red +fish", 1, {0, 2});
+    EXPECT(cache.lookup("red +fish", 1, ids));
+    EXPECT_EQUAL(ids, {0, 2});
+    EXPECT_EQUAL(cache.hits(), 1);
+    EXPECT_EQUAL(cache.misses(), 1);
+    EXPECT_EQUAL(cache.hitRate(), 0.5);
+}
+
+STUDENT_TEST("QueryCache evicts least recently used entry when full") {
+    Vector<int> ids = {1, 2, 3, 4};
+    int entryBytes = ENTRY_OVERHEAD + 1 + ids.size() * sizeof(int);
+    QueryCache cache(2 * entryBytes);
+    cache.store("a", 1, ids);
+    cache.store("b", 1, ids);
+    EXPECT(cache.lookup("a", 1, ids)); // a is now most recent
+    cache.store("c", 1, ids);          // evicts b
+    EXPECT_EQUAL(cache.size(), 2);
+    EXPECT(cache.bytesUsed() <= 2 * entryBytes);
+    EXPECT(cache.lookup("a", 1, ids));
+    EXPECT(!cache.lookup("b", 1, ids));
+    EXPECT(cache.lookup("c", 1, ids));
+    EXPECT_EQUAL(cache.evictions(), 1);
+
+    Vector<int> huge(entryBytes, 0);
+    cache.store("huge", 1, huge);      // larger than budget, not cached
+    EXPECT(!cache.lookup("huge", 1, ids));
+}
+
+STUDENT_TEST("QueryCache drops entries when index generation changes") {
+    QueryCache cache(QUERY_CACHE_BYTES);
+    Vector<int> ids;
+    cache.store("fish", 1, {0, 1, 2});
+    EXPECT(cache.lookup("fish", 1, ids));
+    EXPECT(!cache.lookup("fish", 2, ids));
+    EXPECT_EQUAL(cache.size(), 0);
+    EXPECT_EQUAL(cache.invalidations(), 1);
+}
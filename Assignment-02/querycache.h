@@ -0,0 +1,90 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "vector.h"
+
+// Default memory budget for the searchEngine query cache
+const int QUERY_CACHE_BYTES = 1 << 20;
+
+/**
+ * Least-recently-used cache of query results for the search engine. Entries
+ * map a query key (see queryKey in search.h) to the list of doc IDs that
+ * matched it. The cache holds at most a fixed number of bytes, counting the
+ * key, the doc IDs and a fixed per-entry overhead.
+ *
+ * Every lookup and store is tagged with the generation of the index it was
+ * computed against. Seeing a new generation drops every cached entry, so
+ * results from a stale index are never returned.
+ */
+class QueryCache {
+public:
+    /**
+     * Creates an empty cache that will hold at most maxBytes of entries.
+     */
+    QueryCache(int maxBytes);
+
+    /**
+     * Looks up the results for key. On a hit, copies them into docIds,
+     * marks the entry most recently used and returns true. On a miss,
+     * returns false and leaves docIds unchanged.
+     */
+    bool lookup(const std::string& key, int generation, Vector<int>& docIds);
+
+    /**
+     * Stores the results for key, evicting least recently used entries
+     * until the new entry fits. A result larger than the whole budget is
+     * not cached.
+     */
+    void store(const std::string& key, int generation, const Vector<int>& docIds);
+
+    /**
+     * Removes all entries. Counters are kept.
+     */
+    void clear();
+
+    int size() const;
+    int bytesUsed() const;
+
+    /*
+     * Counters for sizing the cache. Hit latency is the time spent inside
+     * lookup on a hit; miss latency is the time from a missed lookup to the
+     * store of the same key, i.e. the cost of evaluating the query.
+     */
+    int hits() const;
+    int misses() const;
+    int evictions() const;
+    int invalidations() const;
+    double hitRate() const;
+    double averageHitMicros() const;
+    double averageMissMicros() const;
+
+    /*
+     * Prints the counters above to cout.
+     */
+    void printStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Vector<int> docIds;
+        int bytes;
+    };
+
+    std::list<Entry> _entries;  // most recently used at front
+    std::unordered_map<std::string, std::list<Entry>::iterator> _lookup;
+    int _maxBytes;
+    int _bytesUsed;
+    int _generation;
+
+    std::string _pendingKey;    // key of last missed lookup, for miss latency
+    double _pendingStart;
+
+    int _hits, _misses, _evictions, _invalidations;
+    double _hitMicros, _missMicros;
+    int _timedMisses;
+
+    void checkGeneration(int generation);
+    void evictLast();
+};
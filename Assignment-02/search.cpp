@@ -8,6 +8,9 @@
 #include "error.h"
 #include "filelib.h"
 #include "map.h"
+#include "posindex.h"
+#include "querycache.h"
+#include "termdict.h"
 #include "search.h"
 #include "set.h"
 #include "simpio.h"
@@ -45,6 +48,19 @@ Set<string> gatherTokens(string text) {
     return tokens;
 }
 
+// Like gatherTokens, but keeps every cleaned word in the order it appears,
+// duplicates included. A token's position is its index in the result.
+Vector<string> gatherTokenSequence(string text) {
+    Vector<string> tokens;
+    Vector<string> words = stringSplit(text, " ");
+    for (int i = 0; i < words.size(); i++) {
+        string clean = cleanToken(words[i]);
+        if (!clean.empty())
+            tokens.add(clean);
+    }
+    return tokens;
+}
+
 // Extract set of unique tokens. Store each token as a key and its
 // associated website URL as a value. Returns the number of website URLs,
 // and modifies the index map.
@@ -65,67 +81,154 @@ int buildIndex(Vector<string>& lines, Map<string, Set<string>>& index) {
     return nPages;
 }
 
-// Takes in a dictionary mapping words to their website URLs, along with
-// a specific query with rules. + represents union and - represents intersection.
-// Returns a set of valid matches.
-Set<string> findQueryMatches(Map<string, Set<string>>& index, string query) {
-    Set<string> result;
-    Vector<string>words;
-    words = stringSplit(query, " ");
+// Splits a query into a list of clauses, one per word. A word that starts
+// with + or - becomes an AND or EXCEPT clause on the word before it, any
+// other word is an OR clause. Runs of spaces are collapsed, so two queries
+// that differ only in spacing parse to the same clause list.
+Vector<QueryClause> parseQuery(string query) {
+    Vector<QueryClause> clauses;
+    Vector<string> words = stringSplit(query, " ");
     for (int i = 0; i < words.size(); i++) {
-        if (words[i][0] == '-') {
-            Set<string> phrase1, phrase2;
-            phrase1 = index[words[i-1]];
-            words[i].erase(0,1);
-            phrase2 = index[words[i]];
-            // first, remove previous set b/c we want to find difference
-            for (string s : phrase1) {
-                result.remove(s);
-            }
-            // then, add differing elements
-            phrase1.difference(phrase2);
-            for (string s: phrase1) {
-                result.add(s);
-            }
+        string word = words[i];
+        if (word.empty())
+            continue;
+        QueryClause clause;
+        if (word[0] == '+') {
+            clause.op = QUERY_AND;
+            clause.term = word.substr(1);
         }
-        else if (words[i][0] == '+') {
-            Set<string> phrase1, phrase2;
-            phrase1 = index[words[i-1]];
-            words[i].erase(0,1);
-            phrase2 = index[words[i]];
-            // first, remove previous set b/c we want to find intersection
-            for (string s : phrase1) {
-                result.remove(s);
-            }
-            // then, add intersecting elements
-            phrase1.intersect(phrase2);
-            for (string s : phrase1) {
-                result.add(s);
-            }
+        else if (word[0] == '-') {
+            clause.op = QUERY_EXCEPT;
+            clause.term = word.substr(1);
         }
         else {
-            for (string s : index[words[i]]) {
+            clause.op = QUERY_OR;
+            clause.term = word;
+        }
+        clauses.add(clause);
+    }
+    return clauses;
+}
+
+// Turns a parsed query back into a string with exactly one space between
+// clauses. Equal keys always evaluate to the same matches, which makes this
+// the lookup key for the query cache.
+string queryKey(const Vector<QueryClause>& query) {
+    string key;
+    for (int i = 0; i < query.size(); i++) {
+        if (i > 0)
+            key += ' ';
+        if (query[i].op == QUERY_AND)
+            key += '+';
+        else if (query[i].op == QUERY_EXCEPT)
+            key += '-';
+        key += query[i].term;
+    }
+    return key;
+}
+
+// Evaluates a parsed query clause by clause, left to right. An OR clause adds
+// its pages to the result. An AND/EXCEPT clause replaces the pages of the
+// previous term with their intersection/difference with its own pages.
+Set<string> evaluateQuery(Map<string, Set<string>>& index, const Vector<QueryClause>& query) {
+    Set<string> result;
+    for (int i = 0; i < query.size(); i++) {
+        if (query[i].op == QUERY_OR) {
+            for (string s : index.get(query[i].term)) {
                 result.add(s);
             }
+            continue;
+        }
+        if (i == 0)
+            error("Query cannot begin with + or -");
+
+        Set<string> phrase1, phrase2;
+        phrase1 = index.get(query[i-1].term);
+        phrase2 = index.get(query[i].term);
+        // first, remove previous set b/c we want to find intersection/difference
+        for (string s : phrase1) {
+            result.remove(s);
+        }
+        // then, add intersecting or differing elements
+        if (query[i].op == QUERY_AND)
+            phrase1.intersect(phrase2);
+        else
+            phrase1.difference(phrase2);
+        for (string s : phrase1) {
+            result.add(s);
         }
     }
     return result;
 }
 
+// Takes in a dictionary mapping words to their website URLs, along with
+// a specific query with rules. + represents union and - represents intersection.
+// Returns a set of valid matches.
+Set<string> findQueryMatches(Map<string, Set<string>>& index, string query) {
+    return evaluateQuery(index, parseQuery(query));
+}
+
 // Rearranges a vector of data into an inverted index. Retrieves
 // a website URL through query matching, upon entering an input string.
+// Quoted phrases ("red fish") and NEAR/k queries go to a positional index,
+// single wildcard terms (fish*) to a sorted term dictionary.
+// The indexes are built once; repeated queries are answered from a cache of
+// doc-ID lists (a page's doc ID is its position in the database file).
 void searchEngine(Vector<string>& lines) {
     string input = "";
     Map<string, Set<string>> index;
-    Set<string> matches;
+    PositionalIndex positions;
+    TermDictionary dictionary;
+    Map<string, int> docIds;
+    QueryCache cache(QUERY_CACHE_BYTES);
+
+    int nPages = buildIndex(lines, index);
+    positions.build(lines);
+    dictionary.build(lines);
+    int generation = 1; // bump whenever the indexes are rebuilt
+    for (int id = 0; id < nPages; id++) {
+        docIds[lines[2 * id]] = id;
+    }
+    cout << "Indexed " << nPages << " pages containing " << index.size() << " unique terms\n";
 
     do {
         input = getLine("\nEnter query sentence (RETURN/ENTER to quit): ");
-        int snPages = buildIndex(lines, index);
-        matches = findQueryMatches(index, input);
+        PositionalQuery positional;
+        bool isPositional = parsePositionalQuery(input, positional);
+        bool isWildcard = !isPositional && isWildcardQuery(input);
+        string key;
+        if (isPositional)
+            key = positionalQueryKey(positional);
+        else if (isWildcard)
+            key = cleanPattern(input);
+        else
+            key = queryKey(parseQuery(input));
+
+        Vector<int> ids;
+        if (!cache.lookup(key, generation, ids)) {
+            if (isPositional) {
+                ids = positions.match(positional);
+            }
+            else if (isWildcard) {
+                ids = dictionary.match(key);
+            }
+            else {
+                for (string url : evaluateQuery(index, parseQuery(input))) {
+                    ids.add(docIds[url]);
+                }
+            }
+            cache.store(key, generation, ids);
+        }
+        Set<string> matches;
+        for (int id : ids) {
+            matches.add(lines[2 * id]);
+        }
         cout << "Found " << matches.size() << " matching pages\n" ;
         cout << matches;
     } while (input != "");
+
+    cout << endl;
+    cache.printStats();
 }
 
 /*
@@ -260,3 +363,25 @@ STUDENT_TEST("findQueryMatches extra testing") {
     Set<string> matchesOrAnd = findQueryMatches(index, "green +eat fish -red");
     EXPECT_EQUAL(matchesOrAnd.size(), 2);
 }
+
+STUDENT_TEST("parseQuery collapses spacing and keeps operators") {
+    Vector<QueryClause> query = parseQuery("  green   +eat fish  -red ");
+    EXPECT_EQUAL(query.size(), 4);
+    EXPECT_EQUAL(query[1].op, QUERY_AND);
+    EXPECT_EQUAL(query[1].term, "eat");
+    EXPECT_EQUAL(query[3].op, QUERY_EXCEPT);
+    EXPECT_EQUAL(queryKey(query), "green +eat fish -red");
+    EXPECT_EQUAL(queryKey(parseQuery("green +eat fish -red")), queryKey(query));
+}
+
+STUDENT_TEST("evaluateQuery agrees with findQueryMatches on tiny.txt") {
+    Vector<string> lines;
+    Map<string, Set<string>> index;
+    readDatabaseFile("res/tiny.txt", lines);
+    buildIndex(lines, index);
+    Vector<string> queries = {"fish", "red fish", "red +fish", "fish -red green", "green +eat fish -red"};
+    for (string q : queries) {
+        EXPECT_EQUAL(evaluateQuery(index, parseQuery(q)), findQueryMatches(index, q));
+    }
+    EXPECT_ERROR(findQueryMatches(index, "+fish"));
+}
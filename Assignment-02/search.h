@@ -13,8 +13,25 @@ std::string cleanToken(std::string token);
 
 Set<std::string> gatherTokens(std::string bodyText);
 
+Vector<std::string> gatherTokenSequence(std::string bodyText);
+
 int buildIndex(Vector<std::string>& lines, Map<std::string, Set<std::string>>& index);
 
+// A query is a list of clauses evaluated left to right: "red +fish -blue"
+// parses to {OR red, AND fish, EXCEPT blue}.
+enum QueryOp { QUERY_OR, QUERY_AND, QUERY_EXCEPT };
+
+struct QueryClause {
+    QueryOp op;
+    std::string term;
+};
+
+Vector<QueryClause> parseQuery(std::string query);
+
+std::string queryKey(const Vector<QueryClause>& query);
+
+Set<std::string> evaluateQuery(Map<std::string, Set<std::string>>& index, const Vector<QueryClause>& query);
+
 Set<std::string> findQueryMatches(Map<std::string, Set<std::string>>& index, std::string query);
 
 void searchEngine(Vector<std::string>& lines);
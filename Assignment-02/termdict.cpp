@@ -0,0 +1,397 @@
+/*
+ * Front-coded sorted term dictionary for prefix and wildcard queries,
+ * with a heap-based union of the matched posting lists.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <queue>
+#include "error.h"
+#include "search.h"
+#include "strlib.h"
+#include "termdict.h"
+#include "SimpleTest.h"
+using namespace std;
+
+// terms per front-coded block; a lookup decodes at most one block
+static const int BLOCK_SIZE = 16;
+
+// Appends n to bytes as a little-endian base-128 varint.
+static void appendVarint(vector<unsigned char>& bytes, int n) {
+    unsigned int v = n;
+    while (v >= 0x80) {
+        bytes.push_back((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    bytes.push_back(v);
+}
+
+// Reads a varint starting at bytes[pos] and advances pos past it.
+static int readVarint(const vector<unsigned char>& bytes, int& pos) {
+    unsigned int v = 0;
+    int shift = 0;
+    unsigned char byte;
+    do {
+        byte = bytes[pos++];
+        v |= (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return v;
+}
+
+// Returns true if text matches pattern, where '*' matches any run of characters.
+static bool globMatch(const string& pattern, const string& text) {
+    size_t p = 0, t = 0;
+    size_t starP = string::npos, starT = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == text[t]) {
+            p++;
+            t++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starT = t;
+        }
+        else if (starP != string::npos) {
+            p = starP + 1;
+            t = ++starT;
+        }
+        else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+string cleanPattern(string pattern) {
+    string result;
+    for (char ch : pattern) {
+        if (isalpha(ch) || isdigit(ch))
+            result += tolower(ch);
+        else if (ch == '*' && (result.empty() || result[result.size() - 1] != '*'))
+            result += ch;
+    }
+    return result;
+}
+
+bool isWildcardQuery(string query) {
+    query = trim(query);
+    return query.find('*') != string::npos && query.find(' ') == string::npos
+           && query[0] != '+' && query[0] != '-';
+}
+
+Vector<int> unionPostings(const vector<const int*>& begins, const vector<const int*>& ends) {
+    typedef pair<int, int> Head; // (doc ID, list)
+    priority_queue<Head, vector<Head>, greater<Head>> heap;
+    vector<const int*> cursors = begins;
+    for (size_t i = 0; i < cursors.size(); i++) {
+        if (cursors[i] != ends[i])
+            heap.push(Head(*cursors[i], i));
+    }
+
+    Vector<int> result;
+    while (!heap.empty()) {
+        Head head = heap.top();
+        heap.pop();
+        if (result.isEmpty() || result[result.size() - 1] != head.first)
+            result.add(head.first);
+        int list = head.second;
+        if (++cursors[list] != ends[list])
+            heap.push(Head(*cursors[list], list));
+    }
+    return result;
+}
+
+TermDictionary::TermDictionary() {
+    _numTerms = 0;
+}
+
+/*
+ * Collects each term's pages in a sorted map, then writes the terms out
+ * in order as front-coded blocks and the pages as one flat postings array.
+ */
+int TermDictionary::build(Vector<string>& lines) {
+    map<string, vector<int>> index;
+    int nPages = 0;
+    for (int i = 0; i + 1 < lines.size(); i += 2) {
+        for (string token : gatherTokens(lines[i + 1])) {
+            index[token].push_back(nPages);
+        }
+        nPages++;
+    }
+
+    _terms.clear();
+    _blockStarts.clear();
+    _postingStarts.clear();
+    _postings.clear();
+    _numTerms = 0;
+
+    string prev;
+    for (auto& entry : index) {
+        const string& term = entry.first;
+        if (_numTerms % BLOCK_SIZE == 0) {
+            _blockStarts.push_back(_terms.size());
+            appendVarint(_terms, term.size());
+            _terms.insert(_terms.end(), term.begin(), term.end());
+        }
+        else {
+            size_t shared = 0;
+            while (shared < prev.size() && shared < term.size() && prev[shared] == term[shared])
+                shared++;
+            appendVarint(_terms, shared);
+            appendVarint(_terms, term.size() - shared);
+            _terms.insert(_terms.end(), term.begin() + shared, term.end());
+        }
+        prev = term;
+        _numTerms++;
+        _postingStarts.push_back(_postings.size());
+        _postings.insert(_postings.end(), entry.second.begin(), entry.second.end());
+    }
+    _postingStarts.push_back(_postings.size());
+    return nPages;
+}
+
+int TermDictionary::numTerms() const {
+    return _numTerms;
+}
+
+int TermDictionary::bytesUsed() const {
+    return _terms.size() + (_blockStarts.size() + _postingStarts.size() + _postings.size()) * sizeof(int);
+}
+
+/*
+ * Returns the first (whole) term of a block.
+ */
+string TermDictionary::blockHead(int block) const {
+    int pos = _blockStarts[block];
+    int len = readVarint(_terms, pos);
+    return string(_terms.begin() + pos, _terms.begin() + pos + len);
+}
+
+/*
+ * Decodes the terms with ordinals in [lo, hi), starting from the head of
+ * the block containing lo.
+ */
+void TermDictionary::decodeRange(int lo, int hi, vector<string>& terms) const {
+    terms.clear();
+    if (lo >= hi)
+        return;
+    int block = lo / BLOCK_SIZE;
+    int pos = _blockStarts[block];
+    string term;
+    for (int ord = block * BLOCK_SIZE; ord < hi; ord++) {
+        if (ord % BLOCK_SIZE == 0) {
+            pos = _blockStarts[ord / BLOCK_SIZE];
+            int len = readVarint(_terms, pos);
+            term.assign(_terms.begin() + pos, _terms.begin() + pos + len);
+            pos += len;
+        }
+        else {
+            int shared = readVarint(_terms, pos);
+            int len = readVarint(_terms, pos);
+            term.resize(shared);
+            term.append(_terms.begin() + pos, _terms.begin() + pos + len);
+            pos += len;
+        }
+        if (ord >= lo)
+            terms.push_back(term);
+    }
+}
+
+/*
+ * Returns the ordinal of the first term >= key (numTerms() if none).
+ * Binary searches the block heads, then decodes a single block.
+ */
+int TermDictionary::lowerBound(const string& key) const {
+    int lo = 0, hi = _blockStarts.size();
+    while (lo < hi) { // find first block whose head is > key
+        int mid = (lo + hi) / 2;
+        if (blockHead(mid) <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return 0;
+    int block = lo - 1;
+    int end = min(_numTerms, (block + 1) * BLOCK_SIZE);
+    vector<string> terms;
+    decodeRange(block * BLOCK_SIZE, end, terms);
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (terms[i] >= key)
+            return block * BLOCK_SIZE + i;
+    }
+    return end;
+}
+
+string TermDictionary::termAt(int ordinal) const {
+    if (ordinal < 0 || ordinal >= _numTerms)
+        error("TermDictionary::termAt: ordinal out of range");
+    vector<string> terms;
+    decodeRange(ordinal, ordinal + 1, terms);
+    return terms[0];
+}
+
+int TermDictionary::find(string term) const {
+    int ord = lowerBound(term);
+    if (ord < _numTerms && termAt(ord) == term)
+        return ord;
+    return -1;
+}
+
+void TermDictionary::prefixRange(string prefix, int& lo, int& hi) const {
+    lo = lowerBound(prefix);
+    // terms hold only letters and digits, all of which sort below 0x7f
+    hi = lowerBound(prefix + '\x7f');
+}
+
+/*
+ * Finds the ordinals of all terms matching a cleaned pattern. Only the
+ * range sharing the pattern's literal prefix is decoded; a pattern with a
+ * single trailing '*' takes that range without decoding any term.
+ */
+void TermDictionary::matchOrdinals(const string& pattern, vector<int>& ordinals) const {
+    ordinals.clear();
+    size_t star = pattern.find('*');
+    if (star == string::npos) {
+        int ord = find(pattern);
+        if (ord >= 0)
+            ordinals.push_back(ord);
+        return;
+    }
+
+    int lo, hi;
+    prefixRange(pattern.substr(0, star), lo, hi);
+    if (star == pattern.size() - 1) {
+        for (int ord = lo; ord < hi; ord++) {
+            ordinals.push_back(ord);
+        }
+        return;
+    }
+    vector<string> terms;
+    decodeRange(lo, hi, terms);
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (globMatch(pattern, terms[i]))
+            ordinals.push_back(lo + i);
+    }
+}
+
+Vector<string> TermDictionary::expand(string pattern) const {
+    vector<int> ordinals;
+    matchOrdinals(cleanPattern(pattern), ordinals);
+    Vector<string> result;
+    for (int ord : ordinals) {
+        result.add(termAt(ord));
+    }
+    return result;
+}
+
+Vector<int> TermDictionary::match(string pattern) const {
+    vector<int> ordinals;
+    matchOrdinals(cleanPattern(pattern), ordinals);
+    vector<const int*> begins, ends;
+    for (int ord : ordinals) {
+        begins.push_back(_postings.data() + _postingStarts[ord]);
+        ends.push_back(_postings.data() + _postingStarts[ord + 1]);
+    }
+    return unionPostings(begins, ends);
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+STUDENT_TEST("cleanPattern and isWildcardQuery") {
+    EXPECT_EQUAL(cleanPattern("Fi**sh!*"), "fi*sh*");
+    EXPECT(isWildcardQuery(" fish* "));
+    EXPECT(!isWildcardQuery("fish"));
+    EXPECT(!isWildcardQuery("red fi*"));
+    EXPECT(!isWildcardQuery("+fi*"));
+}
+
+STUDENT_TEST("unionPostings merges and removes duplicates") {
+    vector<int> a = {1, 4, 9}, b = {2, 4, 10}, c = {}, d = {0, 9};
+    vector<const int*> begins = {a.data(), b.data(), c.data(), d.data()};
+    vector<const int*> ends = {a.data() + a.size(), b.data() + b.size(), c.data(), d.data() + d.size()};
+    EXPECT_EQUAL(unionPostings(begins, ends), {0, 1, 2, 4, 9, 10});
+}
+
+STUDENT_TEST("TermDictionary lookups on tiny.txt") {
+    Vector<string> lines;
+    readDatabaseFile("res/tiny.txt", lines);
+    TermDictionary dict;
+    EXPECT_EQUAL(dict.build(lines), 4);
+    EXPECT_EQUAL(dict.numTerms(), 12);
+
+    // terms come back in sorted order
+    for (int i = 1; i < dict.numTerms(); i++) {
+        EXPECT(dict.termAt(i - 1) < dict.termAt(i));
+        EXPECT_EQUAL(dict.find(dict.termAt(i)), i);
+    }
+    EXPECT_EQUAL(dict.find("hippo"), -1);
+
+    EXPECT_EQUAL(dict.expand("b*"), {"blue", "bread"});
+    EXPECT_EQUAL(dict.expand("*e*"), {"blue", "bread", "eat", "green", "one", "red"});
+    EXPECT_EQUAL(dict.expand("r*d"), {"red"});
+    EXPECT(dict.expand("z*").isEmpty());
+    EXPECT_EQUAL(dict.match("fish"), {0, 2, 3});
+    EXPECT_EQUAL(dict.match("f*"), {0, 2, 3});
+    EXPECT_EQUAL(dict.match("*e*"), {0, 1, 2, 3});
+    EXPECT_EQUAL(dict.match("gr*"), {1});
+}
+
+STUDENT_TEST("TermDictionary prefix matches agree with index scan on website.txt") {
+    Vector<string> lines;
+    Map<string, Set<string>> index;
+    readDatabaseFile("res/website.txt", lines);
+    buildIndex(lines, index);
+    TermDictionary dict;
+    dict.build(lines);
+    EXPECT_EQUAL(dict.numTerms(), index.size());
+
+    Vector<string> prefixes = {"a", "co", "s", "wee", "x", "1"};
+    for (string prefix : prefixes) {
+        Set<string> expected, found;
+        for (string term : index) {
+            if (startsWith(term, prefix)) {
+                for (string url : index[term]) {
+                    expected.add(url);
+                }
+            }
+        }
+        for (int id : dict.match(prefix + "*")) {
+            found.add(lines[2 * id]);
+        }
+        EXPECT_EQUAL(found, expected);
+    }
+}
+
+STUDENT_TEST("Time prefix queries on a large synthetic vocabulary") {
+    // 2000 pages of 100 distinct made-up terms each
+    Vector<string> lines;
+    for (int page = 0; page < 2000; page++) {
+        string text;
+        for (int w = 0; w < 100; w++) {
+            int n = (page * 7919 + w * 104729) % 200000;
+            string term = "t";
+            for (; n > 0; n /= 26) {
+                term += char('a' + n % 26);
+            }
+            text += term + " ";
+        }
+        lines.add("page" + integerToString(page));
+        lines.add(text);
+    }
+    TermDictionary dict;
+    TIME_OPERATION(lines.size(), dict.build(lines));
+    cout << "    " << dict.numTerms() << " terms in " << dict.bytesUsed() << " bytes" << endl;
+
+    Vector<string> patterns = {"ta*", "tab*", "tabc*", "t*z", "tzz*"};
+    for (string pattern : patterns) {
+        Vector<int> docs;
+        TIME_OPERATION(dict.expand(pattern).size(), docs = dict.match(pattern));
+        EXPECT(!docs.isEmpty());
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "set.h"
+#include "vector.h"
+
+/**
+ * Sorted dictionary of index terms with prefix and wildcard lookup.
+ *
+ * Terms are kept in sorted order and front coded in blocks: the first term
+ * of each block is stored whole, every other term as the length of the
+ * prefix it shares with the term before it plus the remaining suffix. A
+ * term's ordinal is its rank in sorted order. All terms starting with a
+ * prefix have consecutive ordinals, found with a binary search over block
+ * heads. Doc-ID postings are stored in one flat array indexed by ordinal.
+ */
+class TermDictionary {
+public:
+    TermDictionary();
+
+    /**
+     * Indexes a database in the format read by readDatabaseFile, replacing
+     * any previous contents. Doc IDs are page positions in the file, as in
+     * searchEngine. Returns the number of pages.
+     */
+    int build(Vector<std::string>& lines);
+
+    int numTerms() const;
+
+    /**
+     * Returns the term with the given ordinal.
+     */
+    std::string termAt(int ordinal) const;
+
+    /**
+     * Returns the ordinal of term, or -1 if it is not in the dictionary.
+     */
+    int find(std::string term) const;
+
+    /**
+     * Sets [lo, hi) to the ordinals of all terms starting with prefix.
+     * The range is empty (lo == hi) if there are none.
+     */
+    void prefixRange(std::string prefix, int& lo, int& hi) const;
+
+    /**
+     * Returns the terms matching pattern, where '*' matches any run of
+     * characters. The pattern is cleaned like a query term first.
+     */
+    Vector<std::string> expand(std::string pattern) const;
+
+    /**
+     * Returns the sorted doc IDs of pages containing any term matching
+     * pattern, merging the matched posting lists with a k-way heap union.
+     */
+    Vector<int> match(std::string pattern) const;
+
+    /*
+     * Approximate memory used by the dictionary and postings, in bytes.
+     */
+    int bytesUsed() const;
+
+private:
+    std::vector<unsigned char> _terms;  // front-coded blocks
+    std::vector<int> _blockStarts;      // byte offset of each block in _terms
+    int _numTerms;
+    std::vector<int> _postingStarts;    // postings of ordinal i are [_postingStarts[i], _postingStarts[i+1])
+    std::vector<int> _postings;         // doc IDs, sorted within each term
+
+    std::string blockHead(int block) const;
+    void decodeRange(int lo, int hi, std::vector<std::string>& terms) const;
+    int lowerBound(const std::string& key) const;
+    void matchOrdinals(const std::string& pattern, std::vector<int>& ordinals) const;
+};
+
+/*
+ * Cleans a wildcard pattern the way cleanToken cleans a term, but keeps '*'.
+ */
+std::string cleanPattern(std::string pattern);
+
+/*
+ * Returns true if query is a single wildcard term such as fish* or f*sh.
+ */
+bool isWildcardQuery(std::string query);
+
+/*
+ * Returns the sorted union of several sorted doc ID lists, without
+ * duplicates, using a min-heap over the list heads.
+ */
+Vector<int> unionPostings(const std::vector<const int*>& begins, const std::vector<const int*>& ends);
@@ -3,4 +3,6 @@
 /* Needed for boggle.cpp */
 #include "grid.h"
 #include "lexicon.h"
+#include "trie.h"
 int scoreBoard(Grid<char>& board, Lexicon& lex);
+int scoreBoard(Grid<char>& board, const LexiconTrie& trie);
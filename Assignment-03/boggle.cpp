@@ -11,7 +11,9 @@
 #include "grid.h"
 #include "set.h"
 #include "lexicon.h"
+#include "random.h"
 #include "SimpleTest.h"
+#include "trie.h"
 using namespace std;
 
 /*
@@ -75,6 +77,58 @@ int scoreBoard(Grid<char>& board, Lexicon& lex) {
     return score;
 }
 
+/*
+ * The same search as pathsHelper, carrying the trie node of word instead
+ * of asking the lexicon about the whole word at each step. Letters and
+ * visited locations are added and removed in place.
+ */
+static void pathsHelper(GridLocation loc, LexiconTrie::Node node, string& word, Set<GridLocation>& visited,
+                        Set<string>& valid, Grid<char>& board, const LexiconTrie& trie) {
+    if (visited.contains(loc) || !board.inBounds(loc))
+        return;
+    node = trie.child(node, board[loc]);
+    if (node == LexiconTrie::NO_NODE)
+        return;
+
+    word += tolower(board[loc]);
+    if (trie.isWord(node) && word.size() >= 4) {
+        valid.add(word);
+    }
+
+    visited.add(loc);
+    for (int dr = -1; dr <= 1; dr++) {
+        for (int dc = -1; dc <= 1; dc++) {
+            if (dr != 0 || dc != 0)
+                pathsHelper({loc.row + dr, loc.col + dc}, node, word, visited, valid, board, trie);
+        }
+    }
+    visited.remove(loc);
+    word.pop_back();
+}
+
+/*
+ * Compute the total score for all words found in a boggle board, walking
+ * the trie.
+ */
+int scoreBoard(Grid<char>& board, const LexiconTrie& trie) {
+    int score = 0;
+    string word;
+    Set<GridLocation> visited;
+    Set<string> valid;
+    for (int r = 0; r < board.numRows(); r++) {
+        for (int c = 0; c < board.numCols(); c++) {
+            pathsHelper({r, c}, trie.root(), word, visited, valid, board, trie);
+        }
+    }
+
+    for (string s : valid) {
+        score += points(s);
+    }
+
+    return score;
+}
+
+
 /* * * * * * Test Cases * * * * * */
 
 /* Test helper function to return shared copy of Lexicon. Use to
@@ -84,6 +138,27 @@ static Lexicon& sharedLexicon() {
     return lex;
 }
 
+/* Test helper function to return a shared trie of the same words.
+ * Also used by the tests in bogglesolver.cpp. */
+const LexiconTrie& sharedTrie() {
+    static LexiconTrie trie(sharedLexicon());
+    return trie;
+}
+
+/* Test helper that fills a board with random letters, weighted toward
+ * the common ones so the boards hold many words. Also used by the tests
+ * in bogglesolver.cpp. */
+Grid<char> randomBoard(int rows, int cols) {
+    static const string LETTERS = "AAAAABCDDEEEEEEEFGHIIIIIJKLLMNNNOOOOPQRRRSSSSTTTTUUVWXYZ";
+    Grid<char> board(rows, cols);
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            board[r][c] = LETTERS[randomInteger(0, LETTERS.size() - 1)];
+        }
+    }
+    return board;
+}
+
 PROVIDED_TEST("Load shared Lexicon, confirm number of words") {
     Lexicon lex = sharedLexicon();
     EXPECT_EQUAL(lex.size(), 127145);
@@ -183,3 +258,31 @@ STUDENT_TEST("Test scoreBoard, small number of words in corner of board") {
     }
     EXPECT_EQUAL(valid2, {"bile", "bird", "brie", "cebid", "ceil", "diel", "drib", "lice", "riel", "rile"});
 }
+
+STUDENT_TEST("scoreBoard with LexiconTrie matches scoreBoard with Lexicon") {
+    Grid<char> board = {{'E','A','A','R'},
+                        {'L','V','T','S'},
+                        {'R','A','A','N'},
+                        {'O','I','S','E'}};
+    EXPECT_EQUAL(scoreBoard(board, sharedTrie()), 234);
+    Grid<char> corner = {{'C','_','_','_'},
+                         {'Z','_','_','_'},
+                         {'_','A','_','_'},
+                         {'_','_','R','_'}};
+    EXPECT_EQUAL(scoreBoard(corner, sharedTrie()), 1);
+    for (int i = 0; i < 10; i++) {
+        Grid<char> random = randomBoard(4, 4);
+        EXPECT_EQUAL(scoreBoard(random, sharedTrie()), scoreBoard(random, sharedLexicon()));
+    }
+}
+
+STUDENT_TEST("Time scoreBoard with Lexicon and LexiconTrie") {
+    Grid<char> board = {{'E','A','A','R'},
+                        {'L','V','T','S'},
+                        {'R','A','A','N'},
+                        {'O','I','S','E'}};
+    int fromLexicon = 0, fromTrie = 0;
+    TIME_OPERATION(board.size(), fromLexicon = scoreBoard(board, sharedLexicon()));
+    TIME_OPERATION(board.size(), fromTrie = scoreBoard(board, sharedTrie()));
+    EXPECT_EQUAL(fromTrie, fromLexicon);
+}
@@ -0,0 +1,339 @@
+/*
+ * Boggle solver that walks a trie with a bitmask of visited cells.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+#include "backtracking.h"
+#include "bogglesolver.h"
+#include "error.h"
+#include "random.h"
+#include "set.h"
+#include "SimpleTest.h"
+using namespace std;
+
+const int BoggleSolver::MAX_CELLS;
+const int BoggleSolver::MIN_WORD_LENGTH;
+
+/*
+ * Index of the lowest set bit of a nonzero word.
+ */
+static inline int lowestBit(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+BoggleSolver::BoggleSolver(const LexiconTrie& trie) : _trie(trie), _rows(0), _cols(0), _words(nullptr), _score(0) {
+    _foundIn.assign(trie.numNodes(), 0);
+    _stamp = 0;
+}
+
+int BoggleSolver::scoreBoard(const Grid<char>& board) {
+    return solve(board, nullptr);
+}
+
+Vector<string> BoggleSolver::findWords(const Grid<char>& board) {
+    Vector<string> words;
+    solve(board, &words);
+    return words;
+}
+
+int BoggleSolver::solve(const Grid<char>& board, Vector<string>* words) {
+    startBoard(board, words);
+    for (int cell = 0; cell < _rows * _cols; cell++) {
+        searchFrom(cell);
+    }
+    _words = nullptr;
+    return _score;
+}
+
+/*
+ * Takes in the letters of board, and its neighbor masks if its shape is
+ * new, and forgets the words found on the board before.
+ */
+void BoggleSolver::startBoard(const Grid<char>& board, Vector<string>* words) {
+    int rows = board.numRows(), cols = board.numCols();
+    if (rows * cols > MAX_CELLS)
+        error("BoggleSolver: board has more than 64 cells");
+    if (rows != _rows || cols != _cols) {
+        // the neighbors depend only on the shape of the board
+        _rows = rows;
+        _cols = cols;
+        _neighbors.assign(rows * cols, 0);
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                for (int dr = -1; dr <= 1; dr++) {
+                    for (int dc = -1; dc <= 1; dc++) {
+                        if ((dr != 0 || dc != 0) && board.inBounds(r + dr, c + dc))
+                            _neighbors[r * cols + c] |= uint64_t(1) << ((r + dr) * cols + c + dc);
+                    }
+                }
+            }
+        }
+        _letters.resize(rows * cols);
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            _letters[r * cols + c] = char(tolower((unsigned char)board.get(r, c)));
+        }
+    }
+    if (++_stamp == 0) {
+        // the stamps have wrapped around; clear them once every 2^32 boards
+        fill(_foundIn.begin(), _foundIn.end(), 0);
+        _stamp = 1;
+    }
+    _found.clear();
+    _words = words;
+    _score = 0;
+}
+
+/*
+ * Finds the words of the paths that start at cell.
+ */
+void BoggleSolver::searchFrom(int cell) {
+    LexiconTrie::Node node = _trie.child(_trie.root(), _letters[cell]);
+    if (node != LexiconTrie::NO_NODE)
+        extend(cell, node, 0, 1);
+}
+
+/*
+ * Continues a path that has reached cell, where node holds the length
+ * letters of the path and visited has the cells before this one.
+ */
+void BoggleSolver::extend(int cell, LexiconTrie::Node node, uint64_t visited, int length) {
+    _word[length - 1] = _letters[cell];
+    if (length >= MIN_WORD_LENGTH && _trie.isWord(node) && _foundIn[node] != _stamp) {
+        _foundIn[node] = _stamp;
+        _found.push_back({node, length});
+        _score += length - 3;
+        if (_words != nullptr)
+            _words->add(string(_word, length));
+    }
+    if (!_trie.hasChildren(node))
+        return;
+    visited |= uint64_t(1) << cell;
+    for (uint64_t next = _neighbors[cell] & ~visited; next != 0; next &= next - 1) {
+        int neighbor = lowestBit(next);
+        LexiconTrie::Node child = _trie.child(node, _letters[neighbor]);
+        if (child != LexiconTrie::NO_NODE)
+            extend(neighbor, child, visited, length + 1);
+    }
+}
+
+ParallelBoggleSolver::ParallelBoggleSolver(const LexiconTrie& trie, int numThreads) {
+    if (numThreads <= 0)
+        numThreads = max(1, int(thread::hardware_concurrency()));
+    for (int t = 0; t < numThreads; t++) {
+        _solvers.emplace_back(new BoggleSolver(trie));
+    }
+}
+
+int ParallelBoggleSolver::numThreads() const {
+    return int(_solvers.size());
+}
+
+/*
+ * Calls work(solver) once on each thread, with that thread's solver, the
+ * calling thread taking the first, and waits for all of them.
+ */
+template <typename Work>
+void ParallelBoggleSolver::runOnAllThreads(Work work) {
+    vector<thread> threads;
+    for (size_t t = 1; t < _solvers.size(); t++) {
+        BoggleSolver* solver = _solvers[t].get();
+        threads.emplace_back([work, solver] { work(*solver); });
+    }
+    work(*_solvers[0]);
+    for (thread& worker : threads) {
+        worker.join();
+    }
+}
+
+int ParallelBoggleSolver::scoreBoard(const Grid<char>& board) {
+    if (board.numRows() * board.numCols() > BoggleSolver::MAX_CELLS)
+        error("BoggleSolver: board has more than 64 cells");
+    int numCells = board.numRows() * board.numCols();
+    atomic<int> nextCell(0);
+    runOnAllThreads([&board, &nextCell, numCells](BoggleSolver& solver) {
+        solver.startBoard(board, nullptr);
+        for (int cell = nextCell++; cell < numCells; cell = nextCell++) {
+            solver.searchFrom(cell);
+        }
+    });
+
+    // merge the words of the other threads into the first one's marks
+    BoggleSolver& first = *_solvers[0];
+    for (size_t t = 1; t < _solvers.size(); t++) {
+        for (const BoggleSolver::FoundWord& word : _solvers[t]->_found) {
+            if (first._foundIn[word.node] != first._stamp) {
+                first._foundIn[word.node] = first._stamp;
+                first._score += word.length - 3;
+            }
+        }
+    }
+    return first._score;
+}
+
+Vector<int> ParallelBoggleSolver::scoreBoards(const Vector<Grid<char>>& boards) {
+    for (const Grid<char>& board : boards) {
+        if (board.numRows() * board.numCols() > BoggleSolver::MAX_CELLS)
+            error("BoggleSolver: board has more than 64 cells");
+    }
+    vector<int> scores(boards.size());
+    atomic<int> nextBoard(0);
+    runOnAllThreads([&boards, &scores, &nextBoard](BoggleSolver& solver) {
+        for (int i = nextBoard++; i < boards.size(); i = nextBoard++) {
+            scores[i] = solver.scoreBoard(boards[i]);
+        }
+    });
+    Vector<int> result;
+    for (int score : scores) {
+        result.add(score);
+    }
+    return result;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+const LexiconTrie& sharedTrie();
+Grid<char> randomBoard(int rows, int cols);
+
+/* Test helper function to return shared copy of Lexicon. Use to
+ * avoid (expensive) re-load of word list on each test case. */
+static Lexicon& sharedLexicon() {
+    static Lexicon lex("res/EnglishWords.txt");
+    return lex;
+}
+
+/* Test helper that scores every board with one solver. */
+static long scoreAll(BoggleSolver& solver, const Vector<Grid<char>>& boards) {
+    long total = 0;
+    for (const Grid<char>& board : boards) {
+        total += solver.scoreBoard(board);
+    }
+    return total;
+}
+
+STUDENT_TEST("BoggleSolver finds the words of the provided boards") {
+    BoggleSolver solver(sharedTrie());
+    Grid<char> none = {{'B','C','D','F'},
+                       {'G','H','J','K'},
+                       {'L','M','N','P'},
+                       {'Q','R','S','T'}};
+    EXPECT_EQUAL(solver.scoreBoard(none), 0);
+    Grid<char> corner = {{'L','I','_','_'},
+                         {'M','E','_','_'},
+                         {'_','S','_','_'},
+                         {'_','_','_','_'}};
+    Vector<string> words = solver.findWords(corner);
+    Set<string> found;
+    for (const string& word : words) {
+        found.add(word);
+    }
+    EXPECT_EQUAL(words.size(), found.size());
+    EXPECT_EQUAL(found, {"smile", "limes", "miles", "mile", "mies", "lime", "lies", "elms", "semi"});
+    EXPECT_EQUAL(solver.scoreBoard(corner), 2 + 2 + 2 + 1 + 1 + 1 + 1 + 1 + 1);
+
+    Grid<char> medium = {{'O','T','H','X'},
+                         {'T','H','T','P'},
+                         {'S','S','F','E'},
+                         {'N','A','L','T'}};
+    EXPECT_EQUAL(solver.scoreBoard(medium), 76);
+    Grid<char> large = {{'E','A','A','R'},
+                        {'L','V','T','S'},
+                        {'R','A','A','N'},
+                        {'O','I','S','E'}};
+    EXPECT_EQUAL(solver.scoreBoard(large), 234);
+    // words found on the board before do not count as found on this one
+    EXPECT_EQUAL(solver.scoreBoard(large), 234);
+    EXPECT_ERROR(solver.scoreBoard(Grid<char>(5, 13, 'A')));
+}
+
+STUDENT_TEST("BoggleSolver agrees with scoreBoard on random boards of several shapes") {
+    BoggleSolver solver(sharedTrie());
+    for (int i = 0; i < 20; i++) {
+        Grid<char> board = randomBoard(4, 4);
+        EXPECT_EQUAL(solver.scoreBoard(board), scoreBoard(board, sharedLexicon()));
+    }
+    // the solver keeps its neighbor masks until the shape changes
+    for (GridLocation shape : { GridLocation{1, 1}, {2, 3}, {5, 5}, {5, 5}, {8, 8}, {2, 32}, {1, 64} }) {
+        Grid<char> board = randomBoard(shape.row, shape.col);
+        EXPECT_EQUAL(solver.scoreBoard(board), scoreBoard(board, sharedTrie()));
+    }
+}
+
+STUDENT_TEST("Time BoggleSolver against scoreBoard") {
+    Grid<char> board = {{'E','A','A','R'},
+                        {'L','V','T','S'},
+                        {'R','A','A','N'},
+                        {'O','I','S','E'}};
+    BoggleSolver solver(sharedTrie());
+    int fromLexicon = 0, fromTrie = 0, fromSolver = 0;
+    TIME_OPERATION(board.size(), fromLexicon = scoreBoard(board, sharedLexicon()));
+    TIME_OPERATION(board.size(), fromTrie = scoreBoard(board, sharedTrie()));
+    TIME_OPERATION(board.size(), fromSolver = solver.scoreBoard(board));
+    EXPECT_EQUAL(fromTrie, fromLexicon);
+    EXPECT_EQUAL(fromSolver, fromLexicon);
+
+    int numBoards = 10000;
+    Vector<Grid<char>> boards;
+    for (int i = 0; i < numBoards; i++) {
+        boards.add(randomBoard(4, 4));
+    }
+    long total = 0;
+    TIME_OPERATION(numBoards, total = scoreAll(solver, boards));
+    EXPECT(total > 0);
+}
+
+STUDENT_TEST("ParallelBoggleSolver agrees with BoggleSolver") {
+    BoggleSolver solver(sharedTrie());
+    Vector<Grid<char>> boards;
+    for (GridLocation shape : { GridLocation{4, 4}, {4, 4}, {1, 1}, {5, 5}, {8, 8}, {8, 8}, {3, 7} }) {
+        boards.add(randomBoard(shape.row, shape.col));
+    }
+    Vector<int> expected;
+    for (const Grid<char>& board : boards) {
+        expected.add(solver.scoreBoard(board));
+    }
+    for (int threads : {1, 2, 3, 8}) {
+        ParallelBoggleSolver parallel(sharedTrie(), threads);
+        EXPECT_EQUAL(parallel.numThreads(), threads);
+        for (int i = 0; i < boards.size(); i++) {
+            EXPECT_EQUAL(parallel.scoreBoard(boards[i]), expected[i]);
+        }
+        EXPECT_EQUAL(parallel.scoreBoards(boards), expected);
+        EXPECT(parallel.scoreBoards({}).isEmpty());
+        EXPECT_ERROR(parallel.scoreBoard(Grid<char>(9, 9, 'A')));
+        EXPECT_ERROR(parallel.scoreBoards({Grid<char>(4, 4, 'A'), Grid<char>(9, 9, 'A')}));
+    }
+}
+
+STUDENT_TEST("Time ParallelBoggleSolver on many boards and on one large board") {
+    int numBoards = 20000;
+    Vector<Grid<char>> boards;
+    for (int i = 0; i < numBoards; i++) {
+        boards.add(randomBoard(4, 4));
+    }
+    ParallelBoggleSolver one(sharedTrie(), 1), all(sharedTrie());
+    Vector<int> sequential, parallel;
+    TIME_OPERATION(numBoards, sequential = one.scoreBoards(boards));
+    TIME_OPERATION(numBoards, parallel = all.scoreBoards(boards));
+    EXPECT_EQUAL(parallel, sequential);
+
+    Grid<char> large = randomBoard(8, 8);
+    int fromOne = 0, fromAll = 0;
+    TIME_OPERATION(large.size(), fromOne = one.scoreBoard(large));
+    TIME_OPERATION(large.size(), fromAll = all.scoreBoard(large));
+    EXPECT_EQUAL(fromAll, fromOne);
+}
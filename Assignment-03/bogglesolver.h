@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "trie.h"
+#include "vector.h"
+
+/**
+ * Finds the words on Boggle boards of up to 64 cells, with the rules of
+ * scoreBoard: a word follows a path of neighboring cells, horizontally,
+ * vertically or diagonally, uses each cell at most once, has at least
+ * MIN_WORD_LENGTH letters, and counts once however many paths spell it.
+ *
+ * The search carries a trie node for the letters so far, so each step is
+ * one child lookup. The cells on the path are bits of one 64-bit mask,
+ * passed by value, so nothing is copied or undone on return. The
+ * neighbors of each cell are a precomputed mask too, and the next cells
+ * to try are the neighbor bits not yet visited. Letters go into a fixed
+ * buffer that is only turned into strings when words are asked for.
+ *
+ * A found word is marked on its trie node with the number (stamp) of the
+ * board being solved, rather than added to a Set<string>, so starting the
+ * next board only bumps the stamp. A solver reuses these arrays from
+ * board to board, so one solver must not solve boards on several threads
+ * at once; the trie can be shared by any number of solvers.
+ */
+class BoggleSolver {
+public:
+    /**
+     * Makes a solver for the words of trie, which must outlive it.
+     */
+    explicit BoggleSolver(const LexiconTrie& trie);
+
+    /**
+     * Returns the total points of the words on board. Raises an error if
+     * the board has more than MAX_CELLS cells.
+     */
+    int scoreBoard(const Grid<char>& board);
+
+    /**
+     * Returns the words on board, in lowercase and in the order found.
+     */
+    Vector<std::string> findWords(const Grid<char>& board);
+
+    static const int MAX_CELLS = 64;
+    static const int MIN_WORD_LENGTH = 4;
+
+private:
+    friend class ParallelBoggleSolver;
+
+    struct FoundWord {
+        LexiconTrie::Node node;
+        int length;
+    };
+
+    const LexiconTrie& _trie;
+    int _rows, _cols;
+    std::vector<uint64_t> _neighbors;   // per cell: a bit for each neighboring cell
+    std::vector<char> _letters;         // per cell, row by row, in lowercase
+    std::vector<uint32_t> _foundIn;     // per trie node: stamp of the last board it was found on
+    uint32_t _stamp;
+    char _word[MAX_CELLS];
+    std::vector<FoundWord> _found;      // the words found on this board, in order
+    Vector<std::string>* _words;        // where to add found words, or nullptr
+    int _score;
+
+    int solve(const Grid<char>& board, Vector<std::string>* words);
+    void startBoard(const Grid<char>& board, Vector<std::string>* words);
+    void searchFrom(int cell);
+    void extend(int cell, LexiconTrie::Node node, uint64_t visited, int length);
+};
+
+/**
+ * Scores boards with BoggleSolvers on several threads, sharing one
+ * read-only trie. Work is handed out from an atomic counter, so a thread
+ * that finishes early takes the next piece rather than waiting on a
+ * fixed share:
+ *
+ *  - scoreBoard splits one board by starting cell. Each thread marks the
+ *    words it finds with its own solver's stamps; at the end, the words
+ *    of the other threads are merged into the first thread's marks, so a
+ *    word found from two starting cells on two threads counts once. The
+ *    threads cost more to start than a 4x4 board takes to solve, so this
+ *    pays off only on large boards with many words.
+ *  - scoreBoards hands out whole boards, which is the way to score many.
+ *
+ * The solvers are kept from call to call, and each call runs its work on
+ * numThreads - 1 new threads plus the calling thread, as the other
+ * parallel functions of this project do. One ParallelBoggleSolver must
+ * not be used from several threads at once.
+ */
+class ParallelBoggleSolver {
+public:
+    /**
+     * Makes solvers for numThreads threads, by default one per core.
+     */
+    explicit ParallelBoggleSolver(const LexiconTrie& trie, int numThreads = 0);
+
+    int scoreBoard(const Grid<char>& board);
+    Vector<int> scoreBoards(const Vector<Grid<char>>& boards);
+
+    int numThreads() const;
+
+private:
+    std::vector<std::unique_ptr<BoggleSolver>> _solvers;   // one per thread
+
+    template <typename Work>
+    void runOnAllThreads(Work work);
+};
@@ -0,0 +1,330 @@
+/*
+ * External-memory k-way merge of sorted run files.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include "error.h"
+#include "extmerge.h"
+#include "losertree.h"
+#include "SimpleTest.h"
+using namespace std;
+
+static const size_t BUFFER_ALIGNMENT = 4096;
+
+/*
+ * A block of ints aligned to a page, so reads land on whole pages.
+ */
+class AlignedBuffer {
+public:
+    explicit AlignedBuffer(size_t count) : _storage(new char[count * sizeof(int) + BUFFER_ALIGNMENT]) {
+        uintptr_t address = uintptr_t(_storage.get());
+        _data = (int*)((address + BUFFER_ALIGNMENT - 1) & ~uintptr_t(BUFFER_ALIGNMENT - 1));
+    }
+
+    int* data() {
+        return _data;
+    }
+
+private:
+    unique_ptr<char[]> _storage;
+    int* _data;
+};
+
+/*
+ * Reads count ints from in into buffer and returns how many were read,
+ * fewer only at the end of the file. Raises an error if the read fails or
+ * the file ends partway through an int; on a background read, the error
+ * reaches the merge through the future.
+ */
+static size_t readInts(ifstream& in, int* buffer, size_t count, const string& filename) {
+    in.read((char*)buffer, count * sizeof(int));
+    if (in.bad())
+        error("Error reading run file " + filename);
+    size_t bytes = size_t(in.gcount());
+    if (bytes % sizeof(int) != 0)
+        error("Run file " + filename + " ends partway through an int");
+    return bytes / sizeof(int);
+}
+
+/*
+ * One run file read through two buffers. The merge consumes the current
+ * buffer while the next block is read into the other one by a background
+ * task.
+ */
+class RunReader {
+public:
+    RunReader(string filename, size_t bufferInts)
+            : _in(filename, ios::binary), _filename(filename), _bufferInts(bufferInts),
+              _current(bufferInts), _spare(bufferInts) {
+        if (!_in)
+            error("Cannot open run file named " + filename);
+        _count = readInts(_in, _current.data(), _bufferInts, _filename);
+        prefetch();
+    }
+
+    ~RunReader() {
+        if (_pending.valid())
+            _pending.wait();
+    }
+
+    const int* begin() {
+        return _current.data();
+    }
+
+    const int* end() {
+        return _current.data() + _count;
+    }
+
+    /*
+     * Switches to the block read in the background and starts reading the
+     * one after it. Returns false if the run has no more ints.
+     */
+    bool advance() {
+        if (!_pending.valid())
+            return false;
+        _count = _pending.get();
+        swap(_current, _spare);
+        if (_count == 0)
+            return false;
+        prefetch();
+        return true;
+    }
+
+private:
+    ifstream _in;
+    string _filename;
+    size_t _bufferInts;
+    AlignedBuffer _current, _spare;
+    size_t _count;              // ints in _current
+    future<size_t> _pending;    // the read into _spare
+
+    void prefetch() {
+        int* spare = _spare.data();
+        _pending = async(launch::async, [this, spare] { return readInts(_in, spare, _bufferInts, _filename); });
+    }
+};
+
+/*
+ * The runs of the loser tree, refilled from their readers.
+ */
+struct FileRuns {
+    vector<unique_ptr<RunReader>>* readers;
+
+    bool refill(size_t run, const int*& next, const int*& end) {
+        RunReader& reader = *(*readers)[run];
+        if (!reader.advance())
+            return false;
+        next = reader.begin();
+        end = reader.end();
+        return true;
+    }
+};
+
+/*
+ * Collects output ints in a buffer and writes each full buffer in the
+ * background while the other one fills.
+ */
+class RunWriter {
+public:
+    RunWriter(string filename, size_t bufferInts)
+            : _out(filename, ios::binary), _filename(filename), _bufferInts(bufferInts),
+              _current(bufferInts), _spare(bufferInts), _count(0) {
+        if (!_out)
+            error("Cannot open output file named " + filename);
+    }
+
+    ~RunWriter() {
+        if (_pending.valid())
+            _pending.wait();
+    }
+
+    void add(int value) {
+        _current.data()[_count++] = value;
+        if (_count == _bufferInts)
+            flush();
+    }
+
+    /*
+     * Writes everything added so far and waits for it to finish.
+     */
+    void finish() {
+        flush();
+        if (_pending.valid() && !_pending.get())
+            error("Error writing output file " + _filename);
+    }
+
+private:
+    ofstream _out;
+    string _filename;
+    size_t _bufferInts;
+    AlignedBuffer _current, _spare;
+    size_t _count;
+    future<bool> _pending;      // the write from _spare
+
+    void flush() {
+        if (_pending.valid() && !_pending.get())
+            error("Error writing output file " + _filename);
+        swap(_current, _spare);
+        int* full = _spare.data();
+        size_t count = _count;
+        _count = 0;
+        _pending = async(launch::async, [this, full, count] {
+            _out.write((const char*)full, count * sizeof(int));
+            return bool(_out);
+        });
+    }
+};
+
+uint64_t mergeRunFiles(const Vector<string>& runFiles, string outputFile, size_t bufferBytes) {
+    size_t bufferInts = max(bufferBytes / sizeof(int), size_t(1));
+    vector<unique_ptr<RunReader>> readers;
+    vector<const int*> begins, ends;
+    for (const string& filename : runFiles) {
+        readers.emplace_back(new RunReader(filename, bufferInts));
+        begins.push_back(readers.back()->begin());
+        ends.push_back(readers.back()->end());
+    }
+
+    LoserTree<FileRuns> tree(begins, ends, FileRuns{&readers});
+    RunWriter writer(outputFile, bufferInts);
+    uint64_t written = 0;
+    int prev = numeric_limits<int>::min();
+    bool descent = false;
+    while (!tree.isEmpty()) {
+        int value = tree.pop();
+        descent |= value < prev;
+        prev = value;
+        writer.add(value);
+        written++;
+    }
+    writer.finish();
+    if (descent)
+        error("Run files are not sorted");
+    return written;
+}
+
+Vector<string> generateRunFiles(string prefix, int numRuns, uint64_t runLength, uint32_t seed) {
+    mt19937 random(seed);
+    // gaps average out so a run spans most of the int range
+    uint64_t maxGap = max(uint64_t(1), 2 * (uint64_t(1) << 32) / max(runLength, uint64_t(1)));
+    uniform_int_distribution<uint64_t> gap(0, maxGap - 1);
+    Vector<string> filenames;
+    vector<int> block(1 << 16);
+    for (int r = 0; r < numRuns; r++) {
+        string filename = prefix + to_string(r) + ".run";
+        ofstream out(filename, ios::binary);
+        if (!out)
+            error("Cannot open run file named " + filename);
+        int64_t value = numeric_limits<int>::min();
+        for (uint64_t done = 0; done < runLength; ) {
+            size_t count = size_t(min(uint64_t(block.size()), runLength - done));
+            for (size_t i = 0; i < count; i++) {
+                value = min(value + int64_t(gap(random)), int64_t(numeric_limits<int>::max()));
+                block[i] = int(value);
+            }
+            out.write((const char*)block.data(), count * sizeof(int));
+            done += count;
+        }
+        if (!out)
+            error("Error writing run file " + filename);
+        filenames.add(filename);
+    }
+    return filenames;
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper that reads a whole file of ints. */
+static vector<int> readIntFile(string filename) {
+    ifstream in(filename, ios::binary);
+    vector<int> values;
+    int value;
+    while (in.read((char*)&value, sizeof(value))) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+/* Test helper that deletes the files. */
+static void removeFiles(const Vector<string>& filenames) {
+    for (const string& filename : filenames) {
+        remove(filename.c_str());
+    }
+}
+
+STUDENT_TEST("mergeRunFiles matches an in-memory merge") {
+    // buffers smaller than the runs, so every run refills many times
+    for (int k : {1, 2, 5, 33}) {
+        Vector<string> runs = generateRunFiles("res/test", k, 1000 + 37 * k, 45 + k);
+        vector<int> expected;
+        for (const string& run : runs) {
+            vector<int> values = readIntFile(run);
+            EXPECT(is_sorted(values.begin(), values.end()));
+            expected.insert(expected.end(), values.begin(), values.end());
+        }
+        stable_sort(expected.begin(), expected.end());
+        for (size_t bufferBytes : {4, 256, 1 << 20}) {
+            EXPECT_EQUAL(mergeRunFiles(runs, "res/test.out", bufferBytes), expected.size());
+            EXPECT(readIntFile("res/test.out") == expected);
+        }
+        removeFiles(runs);
+    }
+
+    Vector<string> runs = generateRunFiles("res/test", 2, 0, 45);
+    EXPECT_EQUAL(mergeRunFiles(runs, "res/test.out"), 0);
+    removeFiles(runs);
+    {
+        ofstream out("res/test0.run", ios::binary);
+        int values[] = {1, 5, 3};
+        out.write((const char*)values, sizeof(values));
+    }
+    EXPECT_ERROR(mergeRunFiles({"res/test0.run"}, "res/test.out"));
+    {
+        // a sorted run with a stray byte at the end, past the first buffer
+        ofstream out("res/test0.run", ios::binary);
+        for (int i = 0; i < 100; i++) {
+            out.write((const char*)&i, sizeof(i));
+        }
+        out.put(0);
+    }
+    EXPECT_ERROR(mergeRunFiles({"res/test0.run"}, "res/test.out", 64));
+    EXPECT_ERROR(mergeRunFiles({"res/no-such-file.run"}, "res/test.out"));
+    removeFiles({"res/test0.run", "res/test.out"});
+}
+
+STUDENT_TEST("Time mergeRunFiles against reading the runs") {
+    int k = 16;
+    uint64_t runLength = 1 << 20;   // 4 MB per run
+    // uint64_t runLength = 16 << 20;
+    Vector<string> runs = generateRunFiles("res/time", k, runLength, 450);
+    double megabytes = k * runLength * sizeof(int) / 1e6;
+
+    // the read bandwidth to compare with: the runs read once, in big blocks
+    auto start = chrono::steady_clock::now();
+    vector<char> block(1 << 20);
+    for (const string& run : runs) {
+        ifstream in(run, ios::binary);
+        while (in.read(block.data(), block.size()) || in.gcount() > 0) {
+        }
+    }
+    double readSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t written = 0;
+    start = chrono::steady_clock::now();
+    TIME_OPERATION(k * runLength, written = mergeRunFiles(runs, "res/time.out"));
+    double mergeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    EXPECT_EQUAL(written, k * runLength);
+    cout << "    read " << megabytes / readSeconds << " MB/s, merge " << megabytes / mergeSeconds
+         << " MB/s in and out" << endl;
+    removeFiles(runs);
+    removeFiles({"res/time.out"});
+}
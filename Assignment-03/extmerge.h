@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "vector.h"
+
+/*
+ * Merging of sorted runs stored in files, for data too large for memory.
+ * A run file holds a sorted sequence of ints as raw 4-byte values in the
+ * machine's byte order, with no header; the output file has the same form.
+ */
+
+/*
+ * Merges the sorted run files into outputFile and returns the number of
+ * ints written. Each run is read through two buffers of bufferBytes: while
+ * the merge consumes one, the next block of the run is read into the
+ * other on a background thread. The output goes through two buffers the
+ * same way, so the merge only waits when the disk falls behind. Memory use
+ * is 2 * (k + 1) * bufferBytes for k runs, however long the runs are.
+ *
+ * Raises an error if a file cannot be read or written, or if a run is not
+ * sorted.
+ */
+uint64_t mergeRunFiles(const Vector<std::string>& runFiles, std::string outputFile,
+                       size_t bufferBytes = 1 << 20);
+
+/*
+ * Writes numRuns sorted run files of runLength random ints each, named
+ * prefix0.run, prefix1.run, ..., and returns their names. Values are built
+ * by adding random gaps, so a run of any length is generated in bounded
+ * memory. The same seed gives the same files.
+ */
+Vector<std::string> generateRunFiles(std::string prefix, int numRuns, uint64_t runLength, uint32_t seed);
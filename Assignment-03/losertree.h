@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The runs of a LoserTree when they are all in memory: a run that reaches
+ * its end is finished.
+ */
+struct InMemoryRuns {
+    bool refill(size_t, const int*&, const int*&) {
+        return false;
+    }
+};
+
+/**
+ * A tournament tree over k sorted runs of ints that yields their elements
+ * in order, one at a time, with no intermediate sequences. Each internal
+ * node keeps the loser of the match played there, so replacing the winner
+ * only replays the matches on the path from its leaf to the root: log2(k)
+ * compares against nodes that sit together in one array of 8-byte keys.
+ *
+ * A key packs the element, made unsigned with its order kept, above the
+ * index of its run. Ties on the element go to the lower run, which keeps
+ * the merge stable, and an exhausted run has the largest key of all.
+ *
+ * Each run is read from a range [next, end). When a range is used up the
+ * tree calls runs.refill(run, next, end), which may point the range at
+ * more of the run (at least one element) and return true, or return false
+ * if the run is done. That lets runs stream in from files through buffers.
+ */
+template <typename Runs = InMemoryRuns>
+class LoserTree {
+public:
+    LoserTree(const std::vector<const int*>& begins, const std::vector<const int*>& ends, Runs runs = Runs())
+            : _next(begins), _ends(ends), _runs(runs) {
+        size_t k = begins.size();
+        _leaves = 1;
+        while (_leaves < k) {
+            _leaves *= 2;
+        }
+        // play the first tournament bottom-up, keeping winners in a scratch array
+        std::vector<uint64_t> winners(2 * _leaves, exhausted());
+        for (size_t run = 0; run < k; run++) {
+            winners[_leaves + run] = takeKey(run);
+        }
+        _losers.assign(_leaves, exhausted());
+        for (size_t node = _leaves - 1; node > 0; node--) {
+            _losers[node] = std::max(winners[2 * node], winners[2 * node + 1]);
+            winners[node] = std::min(winners[2 * node], winners[2 * node + 1]);
+        }
+        _winner = _leaves > 1 ? winners[1] : winners[_leaves];
+    }
+
+    /*
+     * Returns whether every run is used up.
+     */
+    bool isEmpty() const {
+        return _winner == exhausted();
+    }
+
+    /*
+     * Returns the smallest element left. Must not be called once the tree
+     * is empty.
+     */
+    int pop() {
+        size_t run = size_t(_winner & 0xFFFFFFFF);
+        int value = int(uint32_t(_winner >> 32) ^ 0x80000000);
+        uint64_t key = takeKey(run);
+        for (size_t node = (_leaves + run) / 2; node > 0; node /= 2) {
+            uint64_t loser = _losers[node];
+            _losers[node] = std::max(loser, key);
+            key = std::min(loser, key);
+        }
+        _winner = key;
+        return value;
+    }
+
+private:
+    std::vector<const int*> _next, _ends;
+    Runs _runs;
+    std::vector<uint64_t> _losers;  // node 1 is the root, node i has children 2i and 2i + 1
+    size_t _leaves;                 // k rounded up to a power of two
+    uint64_t _winner;
+
+    static uint64_t exhausted() {
+        return ~uint64_t(0);
+    }
+
+    uint64_t takeKey(size_t run) {
+        if (_next[run] == _ends[run] && !_runs.refill(run, _next[run], _ends[run]))
+            return exhausted();
+        uint32_t ordered = uint32_t(*_next[run]++) ^ 0x80000000;
+        return uint64_t(ordered) << 32 | run;
+    }
+};
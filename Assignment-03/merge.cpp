@@ -3,53 +3,98 @@
  * Test for non-sorted sequences, perform an iterative binary merge, then
  * merge multiway sequences.
  */
+#include <algorithm>
+#include <cstdint>
 #include <iostream>    // for cout, endl
+#include <limits>
+#include <thread>
+#include "fastcollections.h"
+#include "mergeengine.h"
 #include "queue.h"
+#include "recursion.h"
 #include "SimpleTest.h"
 using namespace std;
 
-bool checkSorted(Queue<int> q) {
-    int prev, curr;
-    if (!q.isEmpty()) {
-        prev = q.peek();
-    }
+/*
+ * The queue functions are written once for any queue type with the Queue
+ * interface, so RingQueue can stand in for Queue. Which is faster depends
+ * on the platform's Queue; the timing test below compares them. They
+ * drain their queues into arrays and run the merges of mergeengine.h.
+ */
 
+/*
+ * Removes the elements of q, front first, into a vector.
+ */
+template <typename QueueType>
+vector<int> drain(QueueType& q) {
+    vector<int> values;
+    values.reserve(q.size());
     while (!q.isEmpty()) {
-        curr = q.dequeue();
-        if (curr < prev)
-            return false;
-        prev = curr;
+        values.push_back(q.dequeue());
     }
-    return true;
+    return values;
 }
+
+template <typename QueueType>
+bool checkSorted(QueueType q) {
+    vector<int> values = drain(q);
+    return findDescent(values.data(), values.size()) == values.size();
+}
+
 /*
  * Merge two individually sorted queues into one larger queue.
- * Raise an error for unsorted queues.
+ * Raise an error for unsorted queues. A merge keeps the order of each
+ * input, so rather than checking both queues first, mergeSorted checks
+ * the output as it is built: it is sorted exactly when they are.
  */
-Queue<int> binaryMerge(Queue<int> a, Queue<int> b) {
-    Queue<int> result;
-    if (!checkSorted(a) || !checkSorted(b))
+template <typename QueueType>
+QueueType binaryMerge(QueueType a, QueueType b) {
+    // a's elements then b's, in one buffer
+    size_t na = a.size(), nb = b.size();
+    vector<int> inputs(na + nb), merged(na + nb);
+    for (size_t i = 0; i < na + nb; i++) {
+        inputs[i] = i < na ? a.dequeue() : b.dequeue();
+    }
+    if (!mergeSorted(inputs.data(), na, inputs.data() + na, nb, merged.data()))
         error("queue not sorted");
-
-    // add smallest element of both queues
-    while (!a.isEmpty() && !b.isEmpty()) {
-        if (a.peek() <= b.peek()) {
-            result.enqueue(a.dequeue());
-        }
-        else if (b.peek() < a.peek()) {
-            result.enqueue(b.dequeue());
-        }
+    QueueType result;
+    reserveIfPossible(result, merged.size());
+    for (int value : merged) {
+        result.enqueue(value);
     }
+    return result;
+}
 
-    // add remaining elements
-    while (!a.isEmpty()) {
-        result.enqueue(a.dequeue());
-    }
-    while (!b.isEmpty()) {
-        result.enqueue(b.dequeue());
-    }
+Queue<int> binaryMerge(Queue<int> a, Queue<int> b) {
+    return binaryMerge<Queue<int>>(a, b);
+}
 
-    return result;
+/*
+ * Returns the index of the first element of data that is smaller than the
+ * one before it, or n if the n elements are sorted. The search compares
+ * 16 elements per step with SSE2; see findDescent in mergeengine.h.
+ */
+size_t findUnsorted(const int* data, size_t n) {
+    return findDescent(data, n);
+}
+
+/*
+ * Merges the sorted arrays a and b into out, which must have room for
+ * na + nb elements, and returns whether both inputs were sorted. This is
+ * the branchless two-way merge of mergeengine.h for ints.
+ */
+bool mergeSpans(const int* a, size_t na, const int* b, size_t nb, int* out) {
+    return mergeSorted(a, na, b, nb, out);
+}
+
+/*
+ * Merges the sorted vectors a and b into out, reusing out's storage.
+ * Raises an error if either input is not sorted.
+ */
+void binaryMerge(const vector<int>& a, const vector<int>& b, vector<int>& out) {
+    out.resize(a.size() + b.size());
+    if (!mergeSpans(a.data(), a.size(), b.data(), b.size(), out.data()))
+        error("queue not sorted");
 }
 
 /*
@@ -93,6 +138,155 @@ Queue<int> recMultiMerge(Vector<Queue<int>>& all) {
     }
 }
 
+/*
+ * Merges the runs [begins[i], ends[i]) into out and returns whether they
+ * were all sorted, which shows as a descent in the output.
+ */
+static bool mergeRuns(const vector<const int*>& begins, const vector<const int*>& ends, int* out, size_t total) {
+    return mergeSortedRuns(begins, ends, out, total);
+}
+
+/*
+ * Merges the sorted runs into out. Raises an error if a run is not sorted.
+ */
+void multiMerge(const vector<vector<int>>& runs, vector<int>& out) {
+    vector<const int*> begins, ends;
+    size_t total = 0;
+    for (const vector<int>& run : runs) {
+        begins.push_back(run.data());
+        ends.push_back(run.data() + run.size());
+        total += run.size();
+    }
+    out.resize(total);
+    if (!mergeRuns(begins, ends, out.data(), total))
+        error("queue not sorted");
+}
+
+/*
+ * Finds where each run splits so that the elements before the splits are
+ * the rank smallest of all, and stores the split positions in splits.
+ * This is co-ranking: a binary search over values finds the element of
+ * that rank, counting elements below a value with one binary search per
+ * run. Elements equal to it are then taken from the lowest runs first,
+ * which is the order a stable merge would output them in.
+ */
+static void coRank(const vector<vector<int>>& runs, size_t rank, vector<size_t>& splits) {
+    int64_t low = numeric_limits<int>::min(), high = numeric_limits<int>::max();
+    // find the smallest value v with more than rank elements <= v
+    size_t total = 0;
+    for (const vector<int>& run : runs) {
+        total += run.size();
+    }
+    if (rank >= total) {
+        for (size_t i = 0; i < runs.size(); i++) {
+            splits[i] = runs[i].size();
+        }
+        return;
+    }
+    while (low < high) {
+        int64_t mid = low + (high - low) / 2;
+        size_t atMost = 0;
+        for (const vector<int>& run : runs) {
+            atMost += upper_bound(run.begin(), run.end(), int(mid)) - run.begin();
+        }
+        if (atMost > rank)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    int value = int(low);
+    size_t below = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        splits[i] = lower_bound(runs[i].begin(), runs[i].end(), value) - runs[i].begin();
+        below += splits[i];
+    }
+    size_t equalNeeded = rank - below;
+    for (size_t i = 0; i < runs.size() && equalNeeded > 0; i++) {
+        size_t equal = (upper_bound(runs[i].begin(), runs[i].end(), value) - runs[i].begin()) - splits[i];
+        size_t take = min(equal, equalNeeded);
+        splits[i] += take;
+        equalNeeded -= take;
+    }
+}
+
+/*
+ * Merges the sorted runs into out on numThreads threads, with the same
+ * result as multiMerge. The output is cut into equal slices, and the
+ * positions in every run where each slice starts are found by co-ranking.
+ * Then each thread merges its own slice of every run into its own slice of
+ * the output, with no further coordination. numThreads of 0 uses one
+ * thread per core. Raises an error if a run is not sorted.
+ */
+void parallelMultiMerge(const vector<vector<int>>& runs, vector<int>& out, int numThreads) {
+    size_t total = 0;
+    for (const vector<int>& run : runs) {
+        total += run.size();
+    }
+    if (numThreads <= 0)
+        numThreads = total < (1 << 16) ? 1 : max(1, int(thread::hardware_concurrency()));
+    size_t k = runs.size();
+    out.resize(total);
+
+    // splits[t] holds where slice t starts in every run
+    vector<vector<size_t>> splits(numThreads + 1, vector<size_t>(k));
+    for (int t = 0; t <= numThreads; t++) {
+        coRank(runs, total * t / numThreads, splits[t]);
+    }
+    // on unsorted runs the binary searches can give splits out of order
+    bool sorted = true;
+    for (int t = 0; t < numThreads; t++) {
+        for (size_t i = 0; i < k; i++) {
+            sorted &= splits[t][i] <= splits[t + 1][i];
+        }
+    }
+    if (!sorted)
+        error("queue not sorted");
+
+    vector<char> sliceSorted(numThreads);
+    auto mergeSlice = [&](int t) {
+        vector<const int*> begins(k), ends(k);
+        for (size_t i = 0; i < k; i++) {
+            begins[i] = runs[i].data() + splits[t][i];
+            ends[i] = runs[i].data() + splits[t + 1][i];
+        }
+        size_t first = total * t / numThreads, last = total * (t + 1) / numThreads;
+        sliceSorted[t] = mergeRuns(begins, ends, out.data() + first, last - first);
+    };
+    vector<thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(mergeSlice, t);
+    }
+    mergeSlice(0);
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    for (int t = 0; t < numThreads; t++) {
+        size_t first = total * t / numThreads;
+        sorted &= sliceSorted[t] && (first == 0 || first == total || out[first - 1] <= out[first]);
+    }
+    if (!sorted)
+        error("queue not sorted");
+}
+
+/*
+ * Merges k sorted queues with a loser tree, with the same result as
+ * recMultiMerge.
+ */
+Queue<int> tournamentMultiMerge(Vector<Queue<int>>& all) {
+    vector<vector<int>> runs(all.size());
+    for (int i = 0; i < all.size(); i++) {
+        Queue<int> q = all[i];
+        runs[i] = drain(q);
+    }
+    vector<int> merged;
+    multiMerge(runs, merged);
+    Queue<int> result;
+    for (int value : merged) {
+        result.enqueue(value);
+    }
+    return result;
+}
+
 
 /* * * * * * Test Cases * * * * * */
 
@@ -178,6 +372,250 @@ STUDENT_TEST("check sorted") {
 
     Queue<int> q3 = {1, 2, 2, 3, 4};
     EXPECT_EQUAL(checkSorted(q3), true);
+
+    RingQueue<int> q4 = {1, -2, 3, 4};
+    EXPECT_EQUAL(checkSorted(q4), false);
+}
+
+STUDENT_TEST("findUnsorted finds the first descent") {
+    EXPECT_EQUAL(findUnsorted(nullptr, 0), 0);
+    int one[] = {5};
+    EXPECT_EQUAL(findUnsorted(one, 1), 1);
+    int some[] = {1, 2, 2, 3, 4, 0, 5, -1};
+    EXPECT_EQUAL(findUnsorted(some, 8), 5);
+    EXPECT_EQUAL(findUnsorted(some, 5), 5);
+
+    // a single descent at every position, around the 16-element steps
+    for (int n : {2, 15, 16, 17, 33, 64, 100}) {
+        vector<int> values(n);
+        for (int i = 0; i < n; i++) {
+            values[i] = 3 * i;
+        }
+        EXPECT_EQUAL(findUnsorted(values.data(), n), size_t(n));
+        for (int at = 1; at < n; at++) {
+            vector<int> broken = values;
+            broken[at] = broken[at - 1] - 1;
+            EXPECT_EQUAL(findUnsorted(broken.data(), n), size_t(at));
+            broken[at] = numeric_limits<int>::min();
+            broken[at - 1] = numeric_limits<int>::max();
+            EXPECT_EQUAL(findUnsorted(broken.data(), n), size_t(at > 1 && broken[at - 2] > broken[at - 1] ? at - 1 : at));
+        }
+    }
+}
+
+STUDENT_TEST("Time findUnsorted against checkSorted") {
+    int n = 1000000;
+    Queue<int> q = createSequence(n);
+    vector<int> values(n);
+    for (int i = 0; i < n; i++) {
+        values[i] = i;
+    }
+    size_t unsortedAt = 0;
+    TIME_OPERATION(n, checkSorted(q));
+    TIME_OPERATION(n, unsortedAt = findUnsorted(values.data(), n));
+    EXPECT_EQUAL(unsortedAt, size_t(n));
+}
+
+/* Test records: a key with a payload, merged without branches, and one
+   shaped like Assignment 4's DataPoint, whose string takes the other path. */
+struct KeyedRecord {
+    int key;
+    int payload;
+};
+
+struct LabeledPoint {
+    string label;
+    double priority;
+};
+
+/* Test helper that checks mergeSorted and mergeSortedRuns against the
+   stable std::merge and std::stable_sort, for records ordered by less. */
+template <typename Record, typename Less>
+bool mergesStably(const vector<vector<Record>>& runs, Less less, bool sameAs(const Record&, const Record&)) {
+    vector<const Record*> begins, ends;
+    vector<Record> expected;
+    for (const vector<Record>& run : runs) {
+        begins.push_back(run.data());
+        ends.push_back(run.data() + run.size());
+        expected.insert(expected.end(), run.begin(), run.end());
+    }
+    stable_sort(expected.begin(), expected.end(), less);
+    vector<Record> out(expected.size());
+    bool same = mergeSortedRuns(begins, ends, out.data(), out.size(), less)
+            && equal(out.begin(), out.end(), expected.begin(), sameAs);
+
+    if (runs.size() >= 2) {
+        const vector<Record>& a = runs[0];
+        const vector<Record>& b = runs[1];
+        vector<Record> pair(a.size() + b.size());
+        merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), less);
+        same &= mergeSorted(a.data(), a.size(), b.data(), b.size(), pair.data(), less)
+                && equal(pair.begin(), pair.end(), expected.begin(), sameAs);
+    }
+    return same;
+}
+
+STUDENT_TEST("mergeSorted and mergeSortedRuns keep equal keys in input order") {
+    EXPECT(MergeTraits<int>::branchless);
+    EXPECT(MergeTraits<KeyedRecord>::branchless);
+    EXPECT(!MergeTraits<LabeledPoint>::branchless);
+
+    auto byKey = [](const KeyedRecord& x, const KeyedRecord& y) { return x.key < y.key; };
+    auto byPriority = [](const LabeledPoint& x, const LabeledPoint& y) { return x.priority < y.priority; };
+    auto sameRecord = [](const KeyedRecord& x, const KeyedRecord& y) { return x.key == y.key && x.payload == y.payload; };
+    auto samePoint = [](const LabeledPoint& x, const LabeledPoint& y) { return x.label == y.label && x.priority == y.priority; };
+    for (int k : {1, 2, 3, 7}) {
+        for (int trial = 0; trial < 30; trial++) {
+            // few distinct keys, so most records tie with records of other runs
+            vector<vector<KeyedRecord>> records(k);
+            vector<vector<LabeledPoint>> points(k);
+            int id = 0;
+            for (int run = 0; run < k; run++) {
+                int key = randomInteger(-5, 0);
+                for (int i = randomInteger(0, 40); i > 0; i--) {
+                    key += randomInteger(0, 1);
+                    records[run].push_back({key, id});
+                    points[run].push_back({"point" + to_string(id), key / 2.0});
+                    id++;
+                }
+            }
+            EXPECT(mergesStably(records, byKey, +sameRecord));
+            EXPECT(mergesStably(points, byPriority, +samePoint));
+        }
+    }
+
+    // unsorted inputs are reported
+    vector<KeyedRecord> sorted = {{1, 0}, {2, 1}, {4, 2}}, unsorted = {{3, 3}, {1, 4}};
+    vector<KeyedRecord> out(5);
+    EXPECT(!mergeSorted(sorted.data(), 3, unsorted.data(), 2, out.data(), byKey));
+    EXPECT(!mergeSortedRuns<KeyedRecord>({sorted.data(), unsorted.data()}, {sorted.data() + 3, unsorted.data() + 2},
+                                         out.data(), 5, byKey));
+    vector<LabeledPoint> points = {{"a", 1}, {"b", 3}}, reversed = {{"c", 2}, {"d", 0}};
+    vector<LabeledPoint> pointsOut(4);
+    EXPECT(!mergeSorted(points.data(), 2, reversed.data(), 2, pointsOut.data(), byPriority));
+    EXPECT(mergeSorted(points.data(), 2, reversed.data(), 1, pointsOut.data(), byPriority));
+}
+
+STUDENT_TEST("Time mergeSorted on records against std::merge") {
+    int n = 1000000;
+    vector<KeyedRecord> a(n), b(n), out(2 * n);
+    for (int i = 0; i < n; i++) {
+        a[i] = {2 * i + randomInteger(0, 1), i};
+        b[i] = {2 * i + randomInteger(0, 1), n + i};
+    }
+    auto byKey = [](const KeyedRecord& x, const KeyedRecord& y) { return x.key < y.key; };
+    bool sorted = false;
+    TIME_OPERATION(2 * n, merge(a.begin(), a.end(), b.begin(), b.end(), out.begin(), byKey));
+    // the same merge with the sortedness check mergeSorted does along the way
+    TIME_OPERATION(2 * n, sorted = is_sorted(a.begin(), a.end(), byKey) && is_sorted(b.begin(), b.end(), byKey)
+                                   && merge(a.begin(), a.end(), b.begin(), b.end(), out.begin(), byKey) == out.end());
+    TIME_OPERATION(2 * n, sorted = mergeSorted(a.data(), n, b.data(), n, out.data(), byKey));
+    EXPECT(sorted);
+}
+
+STUDENT_TEST("binaryMerge on RingQueue matches Queue") {
+    RingQueue<int> a = {1, 2, 2, 5};
+    RingQueue<int> b = {3, 3};
+    EXPECT_EQUAL(binaryMerge(a, b), RingQueue<int>({1, 2, 2, 3, 3, 5}));
+    EXPECT_EQUAL(binaryMerge(RingQueue<int>(), b), b);
+    EXPECT_ERROR(binaryMerge(RingQueue<int>({4, 9, 2}), b));
+
+    // wrap around the ring: dequeue from the front while enqueueing
+    RingQueue<int> ring;
+    Queue<int> reference;
+    for (int i = 0; i < 1000; i++) {
+        ring.enqueue(i);
+        reference.enqueue(i);
+        if (i % 3 == 0) {
+            EXPECT_EQUAL(ring.dequeue(), reference.dequeue());
+        }
+    }
+    EXPECT_EQUAL(ring.size(), reference.size());
+    EXPECT_EQUAL(ring.peek(), reference.peek());
+    EXPECT_EQUAL(ring.back(), 999);
+    EXPECT_EQUAL(ring.toString().substr(0, 10), "{334, 335,");
+    while (!reference.isEmpty()) {
+        EXPECT_EQUAL(ring.dequeue(), reference.dequeue());
+    }
+    EXPECT_ERROR(ring.dequeue());
+}
+
+STUDENT_TEST("binaryMerge over spans agrees with the Queue version") {
+    vector<int> out;
+    binaryMerge(vector<int>{1, 2, 2, 5}, vector<int>{3, 3}, out);
+    EXPECT(out == vector<int>({1, 2, 2, 3, 3, 5}));
+    binaryMerge(vector<int>{}, vector<int>{3, 3, 8, 10}, out);
+    EXPECT(out == vector<int>({3, 3, 8, 10}));
+    binaryMerge(vector<int>{}, vector<int>{}, out);
+    EXPECT(out.empty());
+    EXPECT_ERROR(binaryMerge(vector<int>{4, 9, 2}, vector<int>{1, 2}, out));
+    EXPECT_ERROR(binaryMerge(vector<int>{1, 2}, vector<int>{5, 4}, out));
+    EXPECT_ERROR(binaryMerge(vector<int>{7, 1, 9}, vector<int>{}, out));
+
+    for (int trial = 0; trial < 200; trial++) {
+        Queue<int> a, b;
+        vector<int> va, vb;
+        for (int i = randomInteger(0, 30); i > 0; i--) {
+            va.push_back(randomInteger(-20, 20));
+        }
+        for (int i = randomInteger(0, 30); i > 0; i--) {
+            vb.push_back(randomInteger(-20, 20));
+        }
+        if (randomChance(0.7)) {
+            sort(va.begin(), va.end());
+            sort(vb.begin(), vb.end());
+        }
+        for (int x : va) a.enqueue(x);
+        for (int x : vb) b.enqueue(x);
+        bool sorted = checkSorted(a) && checkSorted(b);
+        EXPECT_EQUAL(mergeSpans(va.data(), va.size(), vb.data(), vb.size(), (out.resize(va.size() + vb.size()), out.data())), sorted);
+        if (sorted) {
+            Queue<int> expected = binaryMerge(a, b);
+            for (int x : out) {
+                EXPECT_EQUAL(x, expected.dequeue());
+            }
+        }
+    }
+}
+
+STUDENT_TEST("Time binaryMerge on Queue and RingQueue") {
+    int n = 1000000;
+    Queue<int> a = createSequence(n);
+    Queue<int> b = createSequence(n);
+    RingQueue<int> ringA, ringB;
+    for (int i = 0; i < n; i++) {
+        ringA.enqueue(i);
+        ringB.enqueue(i);
+    }
+    TIME_OPERATION(a.size() + b.size(), binaryMerge(a, b));
+    TIME_OPERATION(ringA.size() + ringB.size(), binaryMerge(ringA, ringB));
+}
+
+STUDENT_TEST("Time binaryMerge over spans") {
+    // the same 1M + 1M sizes as the Queue timings above, to compare with
+    int n = 1000000;
+    vector<int> va(n), vb(n), out(2 * n);
+    for (int i = 0; i < n; i++) {
+        va[i] = vb[i] = i;
+    }
+    TIME_OPERATION(va.size() + vb.size(), binaryMerge(va, vb, out));
+    EXPECT(is_sorted(out.begin(), out.end()));
+
+    // randomly interleaved inputs, where a branching merge would mispredict
+    for (int i = 0; i < n; i++) {
+        va[i] = 2 * i + randomInteger(0, 1);
+        vb[i] = 2 * i + randomInteger(0, 1);
+    }
+    TIME_OPERATION(va.size() + vb.size(), binaryMerge(va, vb, out));
+    EXPECT(is_sorted(out.begin(), out.end()));
+
+    // a short input, after which most of each half is one copied block
+    va.resize(n / 10);
+    for (int i = 0; i < n; i++) {
+        vb[i] = i;
+    }
+    TIME_OPERATION(va.size() + vb.size(), binaryMerge(va, vb, out));
+    EXPECT(is_sorted(out.begin(), out.end()));
 }
 
 STUDENT_TEST("binary merge") {
@@ -285,3 +723,89 @@ STUDENT_TEST("recMultiMerge time operation") {
 //    distribute(input4, all4);
 //    TIME_OPERATION(input4.size(), recMultiMerge(all4));
 }
+
+STUDENT_TEST("tournamentMultiMerge agrees with recMultiMerge") {
+    Vector<Queue<int>> all = {{3, 6, 9, 9, 100}, {1, 5, 9, 9, 12}, {5}, {}, {-5, -5}, {3402},
+                              {numeric_limits<int>::min(), numeric_limits<int>::max()}};
+    EXPECT_EQUAL(tournamentMultiMerge(all), naiveMultiMerge(all));
+    Vector<Queue<int>> none;
+    EXPECT(tournamentMultiMerge(none).isEmpty());
+    Vector<Queue<int>> empties(5);
+    EXPECT(tournamentMultiMerge(empties).isEmpty());
+    Vector<Queue<int>> unsorted = {{1, 2}, {4, 3}, {0}};
+    EXPECT_ERROR(tournamentMultiMerge(unsorted));
+
+    for (int k : {1, 2, 3, 7, 64, 100}) {
+        int n = 1000;
+        Vector<Queue<int>> runs(k);
+        distribute(createSequence(n), runs);
+        EXPECT_EQUAL(tournamentMultiMerge(runs), recMultiMerge(runs));
+    }
+}
+
+STUDENT_TEST("Time tournamentMultiMerge against recMultiMerge") {
+    int n = 100000;
+    int k = n/10;
+    Queue<int> input = createSequence(n);
+    Vector<Queue<int>> all(k);
+    distribute(input, all);
+    TIME_OPERATION(input.size(), recMultiMerge(all));
+    TIME_OPERATION(input.size(), tournamentMultiMerge(all));
+
+    // the merge alone, on runs already in vectors, for k up to 100000
+    int n2 = 1000000;
+    for (int k2 : {10, 100, 1000, 10000, 100000}) {
+        vector<vector<int>> runs(k2);
+        for (int i = 0; i < n2; i++) {
+            runs[randomInteger(0, k2 - 1)].push_back(i);
+        }
+        vector<int> out;
+        TIME_OPERATION(n2, multiMerge(runs, out));
+    }
+}
+
+STUDENT_TEST("parallelMultiMerge output is identical to naiveMultiMerge") {
+    for (int k : {1, 2, 5, 100}) {
+        for (int threads : {1, 2, 3, 8}) {
+            // few distinct values, so splits fall inside runs of equal elements
+            Vector<Queue<int>> all(k);
+            vector<vector<int>> runs(k);
+            for (int i = 0; i < 2000; i++) {
+                int run = randomInteger(0, k - 1);
+                runs[run].push_back(i / 50);
+                all[run].enqueue(i / 50);
+            }
+            vector<int> out;
+            parallelMultiMerge(runs, out, threads);
+            Queue<int> expected = naiveMultiMerge(all);
+            EXPECT_EQUAL(int(out.size()), expected.size());
+            bool same = true;
+            for (int value : out) {
+                same &= value == expected.dequeue();
+            }
+            EXPECT(same);
+        }
+    }
+    vector<int> out;
+    parallelMultiMerge({}, out, 4);
+    EXPECT(out.empty());
+    parallelMultiMerge({{}, {numeric_limits<int>::min()}, {numeric_limits<int>::max()}}, out, 3);
+    EXPECT(out == vector<int>({numeric_limits<int>::min(), numeric_limits<int>::max()}));
+    for (int threads : {1, 2, 4}) {
+        EXPECT_ERROR(parallelMultiMerge({{1, 5, 9}, {8, 2, 7, 3}, {4}}, out, threads));
+    }
+}
+
+STUDENT_TEST("Time parallelMultiMerge") {
+    int n = 4000000;
+    for (int k : {16, 1024}) {
+        vector<vector<int>> runs(k);
+        for (int i = 0; i < n; i++) {
+            runs[randomInteger(0, k - 1)].push_back(i);
+        }
+        vector<int> out;
+        TIME_OPERATION(n, multiMerge(runs, out));
+        TIME_OPERATION(n, parallelMultiMerge(runs, out));
+        TIME_OPERATION(n, parallelMultiMerge(runs, out, 4));
+    }
+}
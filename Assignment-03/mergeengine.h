@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "losertree.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Merging of sorted ranges of any record type, ordered by a comparator
+ * less(x, y) that says whether x comes strictly before y. Merges are
+ * stable: records that compare equal come out in input order, the first
+ * input (or lower-numbered run) first. Every merge also checks that its
+ * inputs were sorted as it writes the output, and reports it with its
+ * result, so no separate pass over the inputs is needed.
+ *
+ * The int merges in merge.cpp, on queues as well as on arrays, are
+ * instantiations of these templates with std::less<int>.
+ */
+
+/**
+ * Says how records are moved during a merge. Records that are trivially
+ * copyable and small are selected without branches and copied as bytes;
+ * others, such as records holding strings, are merged with branches so
+ * that each record is copied once. Specialize this to choose for a type.
+ */
+template <typename Record>
+struct MergeTraits {
+    static constexpr bool branchless = std::is_trivially_copyable<Record>::value && sizeof(Record) <= 16;
+};
+
+/**
+ * Says whether a k-way merge of records ordered by Less can run on the
+ * LoserTree of losertree.h, which packs each record and its run into one
+ * 8-byte key so a match is a single compare. That holds for ints in
+ * increasing order; other merges use RecordLoserTree.
+ */
+template <typename Record, typename Less>
+struct PacksIntoKeys : std::false_type {
+};
+
+template <>
+struct PacksIntoKeys<int, std::less<int>> : std::true_type {
+};
+
+/*
+ * Returns the index of the first record of data that comes before the one
+ * ahead of it, or n if the n records are sorted.
+ */
+template <typename Record, typename Less>
+size_t findDescent(const Record* data, size_t n, Less less) {
+    for (size_t i = 1; i < n; i++) {
+        if (less(data[i], data[i - 1]))
+            return i;
+    }
+    return n;
+}
+
+/*
+ * The same for ints in increasing order. With SSE2, each step compares 16
+ * ints against their predecessors, loaded one element back, with four
+ * vector compares and one branch on all of them; the scalar loop then
+ * finds the exact index within the 16 or checks the tail.
+ */
+inline size_t findDescent(const int* data, size_t n, std::less<int> = std::less<int>()) {
+    size_t i = 1;
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16) {
+        __m128i descents = _mm_setzero_si128();
+        for (int k = 0; k < 16; k += 4) {
+            __m128i curr = _mm_loadu_si128((const __m128i*)(data + i + k));
+            __m128i prev = _mm_loadu_si128((const __m128i*)(data + i + k - 1));
+            descents = _mm_or_si128(descents, _mm_cmplt_epi32(curr, prev));
+        }
+        if (_mm_movemask_epi8(descents) != 0)
+            break;      // the loop below finds it
+    }
+#endif
+    for (; i < n; i++) {
+        if (data[i] < data[i - 1])
+            return i;
+    }
+    return n;
+}
+
+/*
+ * Merge of two ranges for small trivially copyable records.
+ *
+ * The inner loop has no data-dependent branch: the record that comes
+ * first is selected and each pointer advances by 0 or 1. Each step still
+ * waits on the loads chosen by the step before, so the first half of the
+ * output is merged from the fronts while the second half is merged from
+ * the backs, giving the processor two independent chains to overlap. Ties
+ * go to a from the front and to b from the back, so both halves are part
+ * of the same stable merge and meet exactly.
+ *
+ * A merge keeps the order of each input, so the output is sorted exactly
+ * when both inputs are. Unsorted inputs can make the halves overlap,
+ * which the check of where they meet catches.
+ */
+template <typename Record, typename Less>
+bool mergeSorted(const Record* a, size_t na, const Record* b, size_t nb, Record* out, Less less, std::true_type) {
+    if (na + nb == 0)
+        return true;
+    const Record* endA = a + na;
+    const Record* endB = b + nb;
+    const Record* frontA = a;
+    const Record* frontB = b;
+    const Record* backA = endA;     // one past the next record from the back
+    const Record* backB = endB;
+    Record* front = out;
+    Record* back = out + na + nb;
+    size_t forward = (na + nb) / 2, backward = na + nb - forward;
+    // the first and last records of the output, so neither check starts with a descent
+    Record lowest = nb == 0 || (na > 0 && !less(b[0], a[0])) ? a[0] : b[0];
+    Record highest = na == 0 || (nb > 0 && !less(b[nb - 1], a[na - 1])) ? b[nb - 1] : a[na - 1];
+    bool descent = false;
+
+    // no input can run out in either direction within this many steps
+    for (size_t steps = std::min(std::min(forward, backward), std::min(na, nb)); steps > 0;
+         steps = std::min(std::min(forward, backward),
+                          size_t(std::min(std::min(endA - frontA, endB - frontB), std::min(backA - a, backB - b))))) {
+        forward -= steps;
+        backward -= steps;
+        for (; steps > 0; steps--) {
+            bool takeA = !less(*frontB, *frontA);
+            Record next = *(takeA ? frontA : frontB);
+            descent |= less(next, lowest);
+            lowest = next;
+            *front++ = next;
+            frontA += takeA;
+            frontB += !takeA;
+
+            bool takeB = !less(backB[-1], backA[-1]);
+            Record last = (takeB ? backB : backA)[-1];
+            descent |= less(highest, last);
+            highest = last;
+            *--back = last;
+            backB -= takeB;
+            backA -= !takeB;
+        }
+    }
+    // finish each half; once one of its inputs has run out, the rest of
+    // the half is a block of the other, checked with findDescent and copied
+    for (; forward > 0 && frontA < endA && frontB < endB; forward--) {
+        bool takeA = !less(*frontB, *frontA);
+        Record next = takeA ? *frontA++ : *frontB++;
+        descent |= less(next, lowest);
+        lowest = next;
+        *front++ = next;
+    }
+    if (forward > 0) {
+        const Record*& rest = frontA < endA ? frontA : frontB;
+        descent |= less(rest[0], lowest) || findDescent(rest, forward, less) != forward;
+        lowest = rest[forward - 1];
+        std::copy(rest, rest + forward, front);
+        rest += forward;
+    }
+    for (; backward > 0 && backA > a && backB > b; backward--) {
+        bool takeB = !less(backB[-1], backA[-1]);
+        Record last = takeB ? *--backB : *--backA;
+        descent |= less(highest, last);
+        highest = last;
+        *--back = last;
+    }
+    if (backward > 0) {
+        const Record*& rest = backA > a ? backA : backB;
+        rest -= backward;
+        descent |= less(highest, rest[backward - 1]) || findDescent(rest, backward, less) != backward;
+        highest = rest[0];
+        std::copy(rest, rest + backward, back - backward);
+    }
+    return !descent && !less(highest, lowest) && frontA == backA && frontB == backB;
+}
+
+/*
+ * Merge of two ranges for other records: one pass from the front, with a
+ * branch per record, so that each record is copied once into out. The
+ * descent check compares each record with the one written before it.
+ */
+template <typename Record, typename Less>
+bool mergeSorted(const Record* a, size_t na, const Record* b, size_t nb, Record* out, Less less, std::false_type) {
+    const Record* endA = a + na;
+    const Record* endB = b + nb;
+    Record* start = out;
+    bool descent = false;
+    while (a < endA && b < endB) {
+        const Record*& source = less(*b, *a) ? b : a;
+        *out = *source++;
+        descent |= out > start && less(*out, out[-1]);
+        out++;
+    }
+    const Record* rest = a < endA ? a : b;
+    size_t count = a < endA ? endA - a : endB - b;
+    descent |= count > 0 && out > start && less(*rest, out[-1]);
+    descent |= findDescent(rest, count, less) != count;
+    std::copy(rest, rest + count, out);
+    return !descent;
+}
+
+/*
+ * Stably merges the sorted ranges a and b into out, which must have room
+ * for na + nb records, and returns whether both inputs were sorted.
+ */
+template <typename Record, typename Less = std::less<Record>>
+bool mergeSorted(const Record* a, size_t na, const Record* b, size_t nb, Record* out, Less less = Less()) {
+    return mergeSorted(a, na, b, nb, out, less, std::integral_constant<bool, MergeTraits<Record>::branchless>());
+}
+
+/**
+ * A tournament tree over k sorted ranges of records, which yields them in
+ * stable order one at a time. Each internal node holds the run that lost
+ * the match played there, so replacing the winner replays log2(k)
+ * matches on the path from its leaf to the root. A match compares the
+ * runs' next records, and a tie goes to the lower run.
+ *
+ * For ints in increasing order, LoserTree packs each element and its run
+ * into one 8-byte key instead, which makes a match a single compare.
+ */
+template <typename Record, typename Less>
+class RecordLoserTree {
+public:
+    RecordLoserTree(const std::vector<const Record*>& begins, const std::vector<const Record*>& ends, Less less)
+            : _next(begins), _ends(ends), _less(less) {
+        _leaves = 1;
+        while (_leaves < begins.size()) {
+            _leaves *= 2;
+        }
+        std::vector<size_t> winners(2 * _leaves);
+        for (size_t leaf = 0; leaf < _leaves; leaf++) {
+            winners[_leaves + leaf] = leaf;
+        }
+        _losers.assign(_leaves, 0);
+        for (size_t node = _leaves - 1; node > 0; node--) {
+            size_t left = winners[2 * node], right = winners[2 * node + 1];
+            bool leftWins = beats(left, right);
+            winners[node] = leftWins ? left : right;
+            _losers[node] = leftWins ? right : left;
+        }
+        _winner = _leaves > 1 ? winners[1] : 0;
+    }
+
+    bool isEmpty() const {
+        return isDone(_winner);
+    }
+
+    /*
+     * Returns the next record in order. Must not be called once the tree
+     * is empty.
+     */
+    const Record& pop() {
+        size_t run = _winner;
+        const Record& record = *_next[run]++;
+        for (size_t node = (_leaves + run) / 2; node > 0; node /= 2) {
+            if (beats(_losers[node], run))
+                std::swap(_losers[node], run);
+        }
+        _winner = run;
+        return record;
+    }
+
+private:
+    std::vector<const Record*> _next, _ends;
+    Less _less;
+    std::vector<size_t> _losers;    // node 1 is the root, node i has children 2i and 2i + 1
+    size_t _leaves;                 // k rounded up to a power of two; runs past k are empty
+    size_t _winner;
+
+    bool isDone(size_t run) const {
+        return run >= _next.size() || _next[run] == _ends[run];
+    }
+
+    // whether run i's next record comes out before run j's
+    bool beats(size_t i, size_t j) const {
+        if (isDone(i) || isDone(j))
+            return !isDone(i);
+        if (_less(*_next[i], *_next[j]))
+            return true;
+        return !_less(*_next[j], *_next[i]) && i < j;
+    }
+};
+
+/*
+ * K-way merge for any records, on a RecordLoserTree. The descent check
+ * compares each record with the one written before it.
+ */
+template <typename Record, typename Less>
+bool mergeSortedRuns(const std::vector<const Record*>& begins, const std::vector<const Record*>& ends,
+                     Record* out, size_t total, Less less, std::false_type) {
+    RecordLoserTree<Record, Less> tree(begins, ends, less);
+    bool descent = false;
+    for (size_t i = 0; i < total; i++) {
+        out[i] = tree.pop();
+        descent |= i > 0 && less(out[i], out[i - 1]);
+    }
+    return !descent;
+}
+
+/*
+ * K-way merge for ints in increasing order, on the packed-key LoserTree.
+ */
+inline bool mergeSortedRuns(const std::vector<const int*>& begins, const std::vector<const int*>& ends,
+                            int* out, size_t total, std::less<int>, std::true_type) {
+    LoserTree<> tree(begins, ends);
+    int prev = std::numeric_limits<int>::min();
+    bool descent = false;
+    for (size_t i = 0; i < total; i++) {
+        int value = tree.pop();
+        descent |= value < prev;
+        prev = value;
+        out[i] = value;
+    }
+    return !descent;
+}
+
+/*
+ * Stably merges the sorted ranges [begins[i], ends[i]) into out, which
+ * must have room for total records, the sum of their lengths. Returns
+ * whether every range was sorted.
+ */
+template <typename Record, typename Less = std::less<Record>>
+bool mergeSortedRuns(const std::vector<const Record*>& begins, const std::vector<const Record*>& ends,
+                     Record* out, size_t total, Less less = Less()) {
+    return mergeSortedRuns(begins, ends, out, total, less, std::integral_constant<bool, PacksIntoKeys<Record, Less>::value>());
+}
@@ -8,6 +8,7 @@
 #include "set.h"
 #include "SimpleTest.h"
 #include "strlib.h"
+#include "trie.h"
 using namespace std;
 
 // keypad is a program-wide constant that stores the Map from integer to
@@ -41,6 +42,36 @@ void predict(string digits, Set<string>& suggestions, Lexicon& lex)
     helpPredict(digits, "", suggestions, lex);
 }
 
+/*
+ * Extends curr by each letter of the next digit, carrying the trie node
+ * of curr, so each letter costs one child step and the letters are added
+ * and removed in place.
+ */
+static void helpPredict(const string& digits, string& curr, LexiconTrie::Node node,
+                        Set<string>& suggestions, const LexiconTrie& trie) {
+    if (curr.length() == digits.length()) {
+        if (trie.isWord(node))
+            suggestions.add(curr);
+        return;
+    }
+    for (char letter : keypad[digits[curr.size()] - 48]) {
+        LexiconTrie::Node next = trie.child(node, letter);
+        if (next != LexiconTrie::NO_NODE) {
+            curr += letter;
+            helpPredict(digits, curr, next, suggestions, trie);
+            curr.pop_back();
+        }
+    }
+}
+
+/*
+ * The same suggestions as predict with a Lexicon, found by walking the trie.
+ */
+void predict(string digits, Set<string>& suggestions, const LexiconTrie& trie) {
+    string curr;
+    helpPredict(digits, curr, trie.root(), suggestions, trie);
+}
+
 
 /* * * * * * Test Cases * * * * * */
 
@@ -73,3 +104,22 @@ STUDENT_TEST("Testing predict function") {
     predict(digits2, suggestions2, sharedLexicon());
     EXPECT_EQUAL(suggestions2, expected2);
 }
+
+STUDENT_TEST("predict with LexiconTrie matches predict with Lexicon") {
+    LexiconTrie trie(sharedLexicon());
+    for (string digits : {"6263", "283", "427746377", "2", "22737", "8378464", "0", "73"}) {
+        Set<string> expected, suggestions;
+        predict(digits, expected, sharedLexicon());
+        predict(digits, suggestions, trie);
+        EXPECT_EQUAL(suggestions, expected);
+    }
+}
+
+STUDENT_TEST("Time predict with Lexicon and LexiconTrie") {
+    LexiconTrie trie(sharedLexicon());
+    string digits = "7378464";
+    Set<string> fromLexicon, fromTrie;
+    TIME_OPERATION(digits.size(), predict(digits, fromLexicon, sharedLexicon()));
+    TIME_OPERATION(digits.size(), predict(digits, fromTrie, trie));
+    EXPECT_EQUAL(fromTrie, fromLexicon);
+}
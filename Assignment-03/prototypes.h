@@ -4,4 +4,6 @@
 #include "set.h"
 #include "lexicon.h"
 #include <string>
+#include "trie.h"
 void predict(std::string digits, Set<std::string>& suggestions, Lexicon& lex);
+void predict(std::string digits, Set<std::string>& suggestions, const LexiconTrie& trie);
@@ -10,6 +10,8 @@ int drawSierpinskiTriangle(GWindow& window,
 void runInteractiveDemo();
 
 /* Needed for merge.cpp */
+#include <cstddef>
+#include <vector>
 #include "queue.h"
 #include "vector.h"
 
@@ -17,3 +19,10 @@ Queue<int> binaryMerge(Queue<int> a, Queue<int> b);
 Queue<int> naiveMultiMerge(Vector<Queue<int>>& all);
 Queue<int> recMultiMerge(Vector<Queue<int>>& all);
 
+size_t findUnsorted(const int* data, size_t n);
+bool mergeSpans(const int* a, size_t na, const int* b, size_t nb, int* out);
+void binaryMerge(const std::vector<int>& a, const std::vector<int>& b, std::vector<int>& out);
+void multiMerge(const std::vector<std::vector<int>>& runs, std::vector<int>& out);
+void parallelMultiMerge(const std::vector<std::vector<int>>& runs, std::vector<int>& out, int numThreads = 0);
+Queue<int> tournamentMultiMerge(Vector<Queue<int>>& all);
+
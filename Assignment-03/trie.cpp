@@ -0,0 +1,210 @@
+/*
+ * Array-packed trie of the words of a lexicon, walked one letter at a
+ * time by the recursive word searches.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include "error.h"
+#include "random.h"
+#include "SimpleTest.h"
+#include "strlib.h"
+#include "trie.h"
+#include "vector.h"
+using namespace std;
+
+const LexiconTrie::Node LexiconTrie::NO_NODE;
+
+LexiconTrie::LexiconTrie(const Lexicon& lex) {
+    vector<string> words;
+    for (const string& word : lex) {
+        words.push_back(word);
+    }
+    build(words);
+}
+
+LexiconTrie::LexiconTrie(string filename) {
+    ifstream in(filename);
+    if (!in)
+        error("Cannot open word file named " + filename);
+    vector<string> words;
+    string word;
+    while (getline(in, word)) {
+        words.push_back(trim(word));
+    }
+    build(words);
+}
+
+/*
+ * Lays out the trie of words breadth first. Once the words are sorted,
+ * the words below a node are a range of them sharing its letters, and the
+ * ranges of its children split that range by the next letter. The queue
+ * of ranges waiting for their nodes is in breadth-first order, and each
+ * node's children are added to it together, so a node's index is its
+ * place in the queue and its children are contiguous.
+ */
+void LexiconTrie::build(vector<string>& words) {
+    words.erase(remove_if(words.begin(), words.end(), [](const string& word) {
+        return word.empty() || any_of(word.begin(), word.end(), [](char ch) { return !isalpha((unsigned char)ch); });
+    }), words.end());
+    for (string& word : words) {
+        word = toLowerCase(word);
+    }
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    _numWords = int(words.size());
+
+    struct WordRange {
+        size_t first, last;     // the words [first, last) share depth letters
+        size_t depth;
+    };
+    vector<WordRange> queue = {{0, words.size(), 0}};
+    _nodes.clear();
+    for (size_t node = 0; node < queue.size(); node++) {
+        WordRange range = queue[node];
+        size_t first = range.first;
+        uint32_t letters = 0;
+        // the word that is the prefix itself sorts first
+        if (first < range.last && words[first].size() == range.depth) {
+            letters |= WORD_BIT;
+            first++;
+        }
+        uint32_t firstChild = uint32_t(queue.size());
+        while (first < range.last) {
+            char ch = words[first][range.depth];
+            size_t last = first + 1;
+            while (last < range.last && words[last][range.depth] == ch) {
+                last++;
+            }
+            letters |= uint32_t(1) << (ch - 'a');
+            queue.push_back({first, last, range.depth + 1});
+            first = last;
+        }
+        _nodes.push_back({letters, firstChild});
+    }
+}
+
+LexiconTrie::Node LexiconTrie::find(const string& prefix) const {
+    Node node = root();
+    for (size_t i = 0; i < prefix.size() && node != NO_NODE; i++) {
+        node = child(node, prefix[i]);
+    }
+    return node;
+}
+
+bool LexiconTrie::contains(const string& word) const {
+    Node node = find(word);
+    return node != NO_NODE && isWord(node);
+}
+
+bool LexiconTrie::containsPrefix(const string& prefix) const {
+    return find(prefix) != NO_NODE;
+}
+
+int LexiconTrie::size() const {
+    return _numWords;
+}
+
+int LexiconTrie::numNodes() const {
+    return int(_nodes.size());
+}
+
+
+/* * * * * * Test Cases * * * * * */
+
+/* Test helper function to return shared copy of Lexicon. Use to
+ * avoid (expensive) re-load of word list on each test case. */
+static Lexicon& sharedLexicon() {
+    static Lexicon lex("res/EnglishWords.txt");
+    return lex;
+}
+
+STUDENT_TEST("LexiconTrie on a few words") {
+    Lexicon lex;
+    LexiconTrie empty(lex);
+    EXPECT_EQUAL(empty.size(), 0);
+    EXPECT(!empty.contains(""));
+    EXPECT(empty.containsPrefix(""));
+    EXPECT_EQUAL(empty.child(empty.root(), 'a'), LexiconTrie::NO_NODE);
+
+    Lexicon words;
+    for (string word : {"cat", "cats", "car", "dog", "Do"}) {
+        words.add(word);
+    }
+    LexiconTrie trie(words);
+    EXPECT_EQUAL(trie.size(), 5);
+    // root, c, d, ca, do, car, cat, dog, cats
+    EXPECT_EQUAL(trie.numNodes(), 9);
+    LexiconTrie::Node ca = trie.find("ca");
+    EXPECT(ca != LexiconTrie::NO_NODE && !trie.isWord(ca) && trie.hasChildren(ca));
+    LexiconTrie::Node cat = trie.child(ca, 'T');
+    EXPECT(trie.isWord(cat));
+    EXPECT_EQUAL(trie.child(cat, 's'), trie.find("cats"));
+    EXPECT(!trie.hasChildren(trie.find("cats")));
+    EXPECT(trie.contains("do") && trie.contains("DOG") && !trie.contains("dogs"));
+    EXPECT(trie.containsPrefix("") && !trie.containsPrefix("cb") && !trie.containsPrefix("ca!"));
+    EXPECT_EQUAL(trie.child(cat, '{'), LexiconTrie::NO_NODE);
+    EXPECT_EQUAL(trie.child(cat, '@'), LexiconTrie::NO_NODE);
+    EXPECT_ERROR(LexiconTrie("res/no-such-file.txt"));
+}
+
+STUDENT_TEST("LexiconTrie agrees with Lexicon on the English words") {
+    Lexicon& lex = sharedLexicon();
+    LexiconTrie trie("res/EnglishWords.txt");
+    EXPECT_EQUAL(trie.size(), lex.size());
+    EXPECT_EQUAL(LexiconTrie(lex).numNodes(), trie.numNodes());
+    bool allFound = true;
+    for (const string& word : lex) {
+        allFound &= trie.contains(word) && trie.containsPrefix(word.substr(0, word.size() / 2));
+    }
+    EXPECT(allFound);
+
+    // random strings, most of them prefixes that run out partway
+    bool same = true;
+    for (int i = 0; i < 20000; i++) {
+        string s;
+        for (int length = randomInteger(1, 8); length > 0; length--) {
+            s += char(randomInteger('a', 'z'));
+        }
+        same &= trie.contains(s) == lex.contains(s) && trie.containsPrefix(s) == lex.containsPrefix(s);
+    }
+    EXPECT(same);
+}
+
+/* Test helper that asks the lexicon about every prefix of every word,
+   each as a new string, the way pathsHelper does. */
+static int countPrefixesAsked(const Lexicon& lex, const Vector<string>& words) {
+    int found = 0;
+    for (const string& word : words) {
+        for (size_t length = 1; length <= word.size(); length++) {
+            found += lex.containsPrefix(word.substr(0, length));
+        }
+    }
+    return found;
+}
+
+/* Test helper that walks every word through the trie with a cursor. */
+static int countPrefixesWalked(const LexiconTrie& trie, const Vector<string>& words) {
+    int found = 0;
+    for (const string& word : words) {
+        LexiconTrie::Node node = trie.root();
+        for (char ch : word) {
+            node = trie.child(node, ch);
+            found += node != LexiconTrie::NO_NODE;
+        }
+    }
+    return found;
+}
+
+STUDENT_TEST("Time prefix walks in LexiconTrie against Lexicon") {
+    Lexicon& lex = sharedLexicon();
+    LexiconTrie trie(lex);
+    Vector<string> words;
+    for (const string& word : lex) {
+        words.add(word);
+    }
+    int asked = 0, walked = 0;
+    TIME_OPERATION(words.size(), asked = countPrefixesAsked(lex, words));
+    TIME_OPERATION(words.size(), walked = countPrefixesWalked(trie, words));
+    EXPECT_EQUAL(walked, asked);
+}
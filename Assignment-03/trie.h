@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "lexicon.h"
+
+/**
+ * A read-only trie of lowercase words packed into one array, for searches
+ * that extend a word one letter at a time. A search holds a node, the
+ * trie's position for the letters so far, and moves to the node for one
+ * more letter with child(node, ch) in O(1), instead of asking the Lexicon
+ * about the whole string again at every step.
+ *
+ * Nodes are laid out in breadth-first order, and the children of a node
+ * sit next to each other in order of their letters. A node is 8 bytes: a
+ * mask with one bit for each letter that has a child, a bit for whether
+ * the letters so far are a word, and the index of the first child. The
+ * child for a letter is that index plus the number of mask bits below the
+ * letter's bit, a popcount. Words with characters other than letters are
+ * left out. Letters may be given in either case.
+ *
+ * Every prefix has its own node, so a node can stand for a word, as the
+ * boggle solver's record of words already found does.
+ */
+class LexiconTrie {
+public:
+    typedef uint32_t Node;
+
+    /**
+     * Builds the trie from the words of a lexicon, or of a word file with
+     * one word per line.
+     */
+    explicit LexiconTrie(const Lexicon& lex);
+    explicit LexiconTrie(std::string filename);
+
+    /**
+     * The node of the empty prefix.
+     */
+    Node root() const {
+        return 0;
+    }
+
+    /**
+     * Returns the node for the letters of node followed by ch, or NO_NODE
+     * if no word starts with them. ch that is not a letter has no child.
+     */
+    Node child(Node node, char ch) const {
+        uint32_t bit = uint32_t((ch | 0x20) - 'a');
+        uint32_t letters = _nodes[node].letters;
+        if (bit >= 26 || !(letters >> bit & 1))
+            return NO_NODE;
+        return _nodes[node].firstChild + countBits(letters & ((uint32_t(1) << bit) - 1));
+    }
+
+    /**
+     * Returns whether the letters leading to node are a word.
+     */
+    bool isWord(Node node) const {
+        return _nodes[node].letters & WORD_BIT;
+    }
+
+    /**
+     * Returns whether some word is longer than the letters leading to node.
+     */
+    bool hasChildren(Node node) const {
+        return _nodes[node].letters & LETTER_BITS;
+    }
+
+    /**
+     * Returns the node for all of prefix, or NO_NODE.
+     */
+    Node find(const std::string& prefix) const;
+
+    bool contains(const std::string& word) const;
+    bool containsPrefix(const std::string& prefix) const;
+
+    int size() const;
+    int numNodes() const;
+
+    static const Node NO_NODE = 0xFFFFFFFF;
+
+private:
+    struct PackedNode {
+        uint32_t letters;       // bit i for letter 'a' + i, and WORD_BIT
+        uint32_t firstChild;
+    };
+    static const uint32_t LETTER_BITS = (1 << 26) - 1;
+    static const uint32_t WORD_BIT = 1 << 26;
+
+    std::vector<PackedNode> _nodes;
+    int _numWords;
+
+    void build(std::vector<std::string>& words);
+
+    static int countBits(uint32_t x) {
+#if defined(__GNUC__)
+        return __builtin_popcount(x);
+#else
+        int count = 0;
+        for (; x != 0; x &= x - 1) {
+            count++;
+        }
+        return count;
+#endif
+    }
+};